@@ -0,0 +1,57 @@
+//
+// propertiesfatfsfile.h
+//
+// Host build replacement for the Circle addon header of the same name,
+// supports the "name=value" lines of the MiniSynth Pi configuration files,
+// a drive prefix (e.g. "SD:/") refers to the current directory
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _Properties_propertiesfatfsfile_h
+#define _Properties_propertiesfatfsfile_h
+
+#include <fatfs/ff.h>
+#include <circle/types.h>
+#include <map>
+#include <string>
+
+class CPropertiesFatFsFile
+{
+public:
+	CPropertiesFatFsFile (const char *pFileName, FATFS *pFileSystem);
+	~CPropertiesFatFsFile (void);
+
+	boolean Load (void);
+	boolean Save (void);
+
+	void RemoveAll (void);
+
+	boolean IsSet (const char *pPropertyName) const;
+
+	unsigned GetNumber (const char *pPropertyName, unsigned nDefault = 0) const;
+	const char *GetString (const char *pPropertyName, const char *pDefault = 0) const;
+
+	void SetNumber (const char *pPropertyName, unsigned nValue, unsigned nBase = 10);
+	void SetString (const char *pPropertyName, const char *pValue);
+
+private:
+	std::string m_FileName;
+
+	std::map<std::string, std::string> m_Properties;
+};
+
+#endif
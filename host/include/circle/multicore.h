@@ -0,0 +1,52 @@
+//
+// multicore.h
+//
+// Host build replacement for the Circle header of the same name,
+// the secondary cores are emulated using one thread each
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _circle_multicore_h
+#define _circle_multicore_h
+
+#include <circle/memory.h>
+#include <circle/sysconfig.h>
+#include <circle/types.h>
+#include <thread>
+
+class CMultiCoreSupport
+{
+public:
+	CMultiCoreSupport (CMemorySystem *pMemorySystem);
+	virtual ~CMultiCoreSupport (void);
+
+	boolean Initialize (void);		// starts the secondary cores
+
+	virtual void Run (unsigned nCore) = 0;	// secondary core entry
+
+	static unsigned ThisCore (void);
+
+private:
+	static void CoreEntry (CMultiCoreSupport *pThis, unsigned nCore);
+
+private:
+	std::thread *m_pCore[CORES];
+
+	static thread_local unsigned s_nThisCore;
+};
+
+#endif
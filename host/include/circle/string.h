@@ -0,0 +1,50 @@
+//
+// string.h
+//
+// Host build replacement for the Circle header of the same name
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _circle_string_h
+#define _circle_string_h
+
+#include <circle/types.h>
+#include <stdarg.h>
+#include <string>
+
+class CString
+{
+public:
+	CString (void) {}
+	CString (const char *pString)		: m_String (pString) {}
+
+	operator const char *(void) const	{ return m_String.c_str (); }
+
+	const char *operator = (const char *pString);
+
+	size_t GetLength (void) const		{ return m_String.length (); }
+
+	void Append (const char *pString)	{ m_String += pString; }
+
+	void Format (const char *pFormat, ...);
+	void FormatV (const char *pFormat, va_list Args);
+
+private:
+	std::string m_String;
+};
+
+#endif
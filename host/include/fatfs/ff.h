@@ -1,10 +1,11 @@
 //
-// synthmodule.h
+// ff.h
 //
-// Base class for synthesizer modules
+// Host build replacement for the FatFs header of the same name,
+// files are accessed using the C library of the host
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -19,15 +20,11 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
-#ifndef _synthmodule_h
-#define _synthmodule_h
+#ifndef _fatfs_ff_h
+#define _fatfs_ff_h
 
-class CSynthModule
+struct FATFS		// the host file system is always mounted
 {
-public:
-	virtual ~CSynthModule (void) {}
-
-	virtual float GetOutputLevel (void) const = 0;	// returns [-1.0, 1.0]
 };
 
 #endif
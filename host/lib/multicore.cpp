@@ -0,0 +1,71 @@
+//
+// multicore.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/multicore.h>
+#include <assert.h>
+
+thread_local unsigned CMultiCoreSupport::s_nThisCore = 0;
+
+CMultiCoreSupport::CMultiCoreSupport (CMemorySystem *pMemorySystem)
+{
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		m_pCore[nCore] = 0;
+	}
+}
+
+CMultiCoreSupport::~CMultiCoreSupport (void)
+{
+	// the derived class has told the secondary cores to return from Run() already
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		if (m_pCore[nCore] != 0)
+		{
+			m_pCore[nCore]->join ();
+
+			delete m_pCore[nCore];
+			m_pCore[nCore] = 0;
+		}
+	}
+}
+
+boolean CMultiCoreSupport::Initialize (void)
+{
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		assert (m_pCore[nCore] == 0);
+		m_pCore[nCore] = new std::thread (CoreEntry, this, nCore);
+	}
+
+	return TRUE;
+}
+
+unsigned CMultiCoreSupport::ThisCore (void)
+{
+	return s_nThisCore;
+}
+
+void CMultiCoreSupport::CoreEntry (CMultiCoreSupport *pThis, unsigned nCore)
+{
+	assert (pThis != 0);
+
+	s_nThisCore = nCore;
+
+	pThis->Run (nCore);
+}
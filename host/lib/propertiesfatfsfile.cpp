@@ -0,0 +1,159 @@
+//
+// propertiesfatfsfile.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <Properties/propertiesfatfsfile.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+CPropertiesFatFsFile::CPropertiesFatFsFile (const char *pFileName, FATFS *pFileSystem)
+{
+	assert (pFileName != 0);
+
+	// files on the drive (e.g. "SD:/midi-cc.txt") are searched in the current directory
+	const char *pDrive = strchr (pFileName, ':');
+	if (   pDrive != 0
+	    && pDrive[1] == '/')
+	{
+		pFileName = pDrive + 2;
+	}
+
+	m_FileName = pFileName;
+}
+
+CPropertiesFatFsFile::~CPropertiesFatFsFile (void)
+{
+}
+
+boolean CPropertiesFatFsFile::Load (void)
+{
+	RemoveAll ();
+
+	FILE *pFile = fopen (m_FileName.c_str (), "r");
+	if (pFile == 0)
+	{
+		return FALSE;
+	}
+
+	char Line[200];
+	while (fgets (Line, sizeof Line, pFile) != 0)
+	{
+		Line[strcspn (Line, "\r\n")] = '\0';
+
+		if (   Line[0] == '#'
+		    || Line[0] == '\0')
+		{
+			continue;
+		}
+
+		char *pValue = strchr (Line, '=');
+		if (pValue == 0)
+		{
+			continue;
+		}
+
+		*pValue++ = '\0';
+
+		m_Properties[Line] = pValue;
+	}
+
+	fclose (pFile);
+
+	return TRUE;
+}
+
+boolean CPropertiesFatFsFile::Save (void)
+{
+	FILE *pFile = fopen (m_FileName.c_str (), "w");
+	if (pFile == 0)
+	{
+		return FALSE;
+	}
+
+	for (auto &Property : m_Properties)
+	{
+		fprintf (pFile, "%s=%s\n", Property.first.c_str (), Property.second.c_str ());
+	}
+
+	return fclose (pFile) == 0;
+}
+
+void CPropertiesFatFsFile::RemoveAll (void)
+{
+	m_Properties.clear ();
+}
+
+boolean CPropertiesFatFsFile::IsSet (const char *pPropertyName) const
+{
+	assert (pPropertyName != 0);
+	return m_Properties.find (pPropertyName) != m_Properties.end ();
+}
+
+unsigned CPropertiesFatFsFile::GetNumber (const char *pPropertyName, unsigned nDefault) const
+{
+	assert (pPropertyName != 0);
+	auto Property = m_Properties.find (pPropertyName);
+	if (Property == m_Properties.end ())
+	{
+		return nDefault;
+	}
+
+	const char *pValue = Property->second.c_str ();
+	char *pEnd = 0;
+	unsigned long ulValue = strtoul (pValue, &pEnd, 0);
+	if (   pEnd == pValue
+	    || *pEnd != '\0')
+	{
+		return nDefault;
+	}
+
+	return (unsigned) ulValue;
+}
+
+const char *CPropertiesFatFsFile::GetString (const char *pPropertyName, const char *pDefault) const
+{
+	assert (pPropertyName != 0);
+	auto Property = m_Properties.find (pPropertyName);
+	if (Property == m_Properties.end ())
+	{
+		return pDefault;
+	}
+
+	return Property->second.c_str ();
+}
+
+void CPropertiesFatFsFile::SetNumber (const char *pPropertyName, unsigned nValue, unsigned nBase)
+{
+	assert (pPropertyName != 0);
+	assert (nBase == 10 || nBase == 16);
+
+	char Buffer[20];
+	snprintf (Buffer, sizeof Buffer, nBase == 10 ? "%u" : "0x%X", nValue);
+
+	m_Properties[pPropertyName] = Buffer;
+}
+
+void CPropertiesFatFsFile::SetString (const char *pPropertyName, const char *pValue)
+{
+	assert (pPropertyName != 0);
+	assert (pValue != 0);
+
+	m_Properties[pPropertyName] = pValue;
+}
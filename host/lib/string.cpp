@@ -0,0 +1,50 @@
+//
+// string.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <circle/string.h>
+#include <stdio.h>
+#include <assert.h>
+
+const char *CString::operator = (const char *pString)
+{
+	assert (pString != 0);
+	m_String = pString;
+
+	return m_String.c_str ();
+}
+
+void CString::Format (const char *pFormat, ...)
+{
+	va_list Args;
+	va_start (Args, pFormat);
+
+	FormatV (pFormat, Args);
+
+	va_end (Args);
+}
+
+void CString::FormatV (const char *pFormat, va_list Args)
+{
+	assert (pFormat != 0);
+
+	char Buffer[1000];
+	vsnprintf (Buffer, sizeof Buffer, pFormat, Args);
+
+	m_String = Buffer;
+}
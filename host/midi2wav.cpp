@@ -0,0 +1,585 @@
+//
+// midi2wav.cpp
+//
+// Renders a Standard MIDI File with a MiniSynth Pi patch into a WAV file
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "voicemanager.h"
+#include "patch.h"
+#include "midiccmap.h"
+#include "eventqueue.h"
+#include "renderring.h"
+#include "sampleconverter.h"
+#include "samplerate.h"
+#include "patchcompiler.h"
+#include "coresync.h"
+#include "simd.h"
+#include "config.h"
+#include "midifile.h"
+#include "wavefile.h"
+#include <fatfs/ff.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <mutex>
+
+#define MIDI_NOTE_OFF		0b1000
+#define MIDI_NOTE_ON		0b1001
+#define MIDI_CONTROL_CHANGE	0b1011
+
+#define CHUNK_FRAMES_DEFAULT	1024		// like the 2048 words PWM and I2S chunks
+#define TAIL_SECS_DEFAULT	2.0		// rendered after the last event
+
+static const char FromMIDI2WAV[] = "midi2wav";
+
+static void Usage (void)
+{
+	fprintf (stderr,
+		 "Usage: %s [-r rate] [-c frames] [-a chunks] [-e] [-t seconds] [-s policy] [-n] [-l dB] patch.txt input.mid output.wav\n\n"
+		 "-r rate\t\tsample rate: 32000, 44100, 48000 or 96000 (default %u)\n"
+		 "-c frames\tframes rendered per chunk (1..%u, default %u)\n"
+		 "-a chunks\tchunks rendered ahead on core %u (default 0)\n"
+		 "-e\t\tthe reverb runs on core %u (with -a only)\n"
+		 "-t seconds\trelease tail after the last event (default %.1f)\n"
+		 "-s policy\tvoice stealing: none, oldest, quietest or released\n"
+		 "-n\t\ta key, which is still playing, gets a new voice\n"
+		 "-l dB\t\tcull released voices below -dB dBFS (0 = off, default %u)\n\n"
+		 "A MIDI CC mapping is read from midi-cc.txt in the current directory.\n",
+		 FromMIDI2WAV, SAMPLE_RATE_DEFAULT, MAX_FRAMES_PER_CHUNK, CHUNK_FRAMES_DEFAULT, RENDER_CORE, EFFECTS_CORE,
+		 TAIL_SECS_DEFAULT, VOICE_CULL_DB);
+}
+
+// the state of CMiniSynthesizer, which is used for rendering
+struct TRenderer
+{
+	CEventQueue EventQueue;
+	CPatchCompiler PatchCompiler;
+	CPatch *pPatch;
+	std::mutex PatchLock;			// like CMiniSynthesizer::GlobalLock()
+
+	CVoiceManager *pVoiceManager;
+	u32 nSampleClock;			// next frame to be rendered
+
+	CRenderRing RenderRing;
+	unsigned nChunkFrames;			// 0 until the first chunk is converted
+	unsigned nAheadFrames;
+};
+
+// same as CMIDIDevice::MIDIMessageHandler() and CMiniSynthesizer do it,
+// but the events are stamped with their exact frame from the MIDI file
+static void PostEvent (CEventQueue *pQueue, u32 nTimestamp,
+		       TSynthEventType Type, u8 ucParam1, u8 ucParam2 = 0)
+{
+	TSynthEvent Event;
+	Event.nTimestamp = nTimestamp;
+	Event.Type = Type;
+	Event.ucParam1 = ucParam1;
+	Event.ucParam2 = ucParam2;
+
+	pQueue->Enqueue (Event);
+}
+
+static void HandleMessage (const TMIDIEvent &Event, u32 nTimestamp, TRenderer *pRenderer,
+			   const CMIDICCMap &CCMap)
+{
+	u8 ucStatus    = Event.Message[0];
+	u8 ucChannel   = ucStatus & 0x0F;
+	u8 ucType      = ucStatus >> 4;
+	u8 ucKeyNumber = Event.Message[1];
+	u8 ucVelocity  = Event.Message[2];
+
+	CEventQueue *pQueue = &pRenderer->EventQueue;
+
+	unsigned nMIDIChannel = pRenderer->pPatch->GetParameter (MIDIChannel);
+	if (   nMIDIChannel != 0		// Omni mode
+	    && nMIDIChannel != (ucChannel + 1U))
+	{
+		return;
+	}
+
+	switch (ucType)
+	{
+	case MIDI_NOTE_ON:
+		if (ucVelocity > 0)
+		{
+			PostEvent (pQueue, nTimestamp, SynthEventNoteOn, ucKeyNumber, ucVelocity);
+		}
+		else
+		{
+			PostEvent (pQueue, nTimestamp, SynthEventNoteOff, ucKeyNumber);
+		}
+		break;
+
+	case MIDI_NOTE_OFF:
+		PostEvent (pQueue, nTimestamp, SynthEventNoteOff, ucKeyNumber);
+		break;
+
+	case MIDI_CONTROL_CHANGE: {
+		TSynthParameter Parameter = CCMap.Map (Event.Message[1]);
+		if (Parameter < SynthParameterUnknown)
+		{
+			PostEvent (pQueue, nTimestamp, SynthEventControlChange, Parameter,
+				   Event.Message[2]);
+		}
+		} break;
+
+	default:				// program change is ignored, there is one patch only
+		break;
+	}
+}
+
+// same as CMiniSynthesizer::ApplyControlChanges()
+static void ApplyControlChanges (TRenderer *pRenderer, u32 nParameters, const u8 *pValue)
+{
+	pRenderer->PatchLock.lock ();
+
+	for (unsigned i = 0; i < SynthParameterUnknown; i++)
+	{
+		if (nParameters & (1U << i))
+		{
+			pRenderer->pPatch->SetMIDIParameter ((TSynthParameter) i, pValue[i]);
+		}
+	}
+
+	const TCompiledPatch *pCompiled =
+		pRenderer->PatchCompiler.Update (pRenderer->pPatch, nParameters);
+
+	pRenderer->PatchLock.unlock ();
+
+	if (pCompiled != 0)
+	{
+		pRenderer->pVoiceManager->SetPatch (pCompiled);
+	}
+}
+
+// same as CMiniSynthesizer::ProcessEvents(), there is no program change
+static unsigned ProcessEvents (TRenderer *pRenderer, unsigned nMaxFrames)
+{
+	CEventQueue *pQueue = &pRenderer->EventQueue;
+	CVoiceManager *pVoiceManager = pRenderer->pVoiceManager;
+
+	pRenderer->PatchLock.lock ();
+
+	const TCompiledPatch *pCompiled = pRenderer->PatchCompiler.PickUp ();
+
+	pRenderer->PatchLock.unlock ();
+
+	if (pCompiled != 0)
+	{
+		pVoiceManager->SetPatch (pCompiled);
+	}
+
+	u32 nParameters = 0;
+	u8 ucValue[SynthParameterUnknown];
+
+	TSynthEvent Event;
+	while (pQueue->Peek (&Event))
+	{
+		// render up to the next event, which is not due yet
+		int nDelay = (int) (Event.nTimestamp - pRenderer->nSampleClock);
+		if (nDelay > 0)
+		{
+			if ((unsigned) nDelay < nMaxFrames)
+			{
+				nMaxFrames = nDelay;
+			}
+
+			break;
+		}
+
+		pQueue->Dequeue (&Event);
+
+		if (Event.Type == SynthEventControlChange)
+		{
+			ucValue[Event.ucParam1] = Event.ucParam2;
+			nParameters |= 1U << Event.ucParam1;
+
+			continue;
+		}
+
+		if (nParameters != 0)
+		{
+			ApplyControlChanges (pRenderer, nParameters, ucValue);
+			nParameters = 0;
+		}
+
+		switch (Event.Type)
+		{
+		case SynthEventNoteOn:
+			pVoiceManager->NoteOn (Event.ucParam1, Event.ucParam2);
+			break;
+
+		case SynthEventNoteOff:
+			pVoiceManager->NoteOff (Event.ucParam1);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (nParameters != 0)
+	{
+		ApplyControlChanges (pRenderer, nParameters, ucValue);
+	}
+
+	pRenderer->nSampleClock += nMaxFrames;
+
+	return nMaxFrames;
+}
+
+// same as CMiniSynthesizer::RenderFrames()
+static void RenderFrames (TRenderer *pRenderer, unsigned nFrames)
+{
+	CVoiceManager *pVoiceManager = pRenderer->pVoiceManager;
+
+	while (nFrames > 0)
+	{
+		unsigned nPart = nFrames;
+		if (nPart > MAX_FRAMES_PER_CHUNK)
+		{
+			nPart = MAX_FRAMES_PER_CHUNK;
+		}
+
+		nPart = ProcessEvents (pRenderer, nPart);
+
+		pVoiceManager->RenderChunk (nPart, &pRenderer->RenderRing);
+
+		nFrames -= nPart;
+	}
+}
+
+#ifdef ARM_ALLOW_MULTI_CORE
+
+// same as CMiniSynthesizer::RenderAhead()
+static boolean RenderAhead (void *pParam)
+{
+	TRenderer *pRenderer = (TRenderer *) pParam;
+
+	unsigned nChunkFrames = __atomic_load_n (&pRenderer->nChunkFrames, __ATOMIC_ACQUIRE);
+	if (   nChunkFrames == 0
+	    ||   pRenderer->RenderRing.GetFilled () + pRenderer->pVoiceManager->GetPendingFrames ()
+	       + nChunkFrames > pRenderer->nAheadFrames)
+	{
+		return FALSE;
+	}
+
+	RenderFrames (pRenderer, nChunkFrames);
+
+	return TRUE;
+}
+
+#endif
+
+int main (int argc, char **argv)
+{
+	unsigned nChunkFrames = CHUNK_FRAMES_DEFAULT;
+	unsigned nAheadChunks = 0;
+	boolean bEffectsCore = FALSE;
+	double fTailSecs = TAIL_SECS_DEFAULT;
+	TVoiceStealing VoiceStealing = CVoiceManager::GetVoiceStealing (0);
+	boolean bRetrigger = TRUE;
+	unsigned nCullLevelDB = VOICE_CULL_DB;
+
+	int nOption;
+	while ((nOption = getopt (argc, argv, "r:c:a:et:s:nl:")) != -1)
+	{
+		switch (nOption)
+		{
+		case 'r':
+			if (!CSampleRate::Set (strtoul (optarg, 0, 0)))
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 'c':
+			nChunkFrames = strtoul (optarg, 0, 0);
+			if (   nChunkFrames == 0
+			    || nChunkFrames > MAX_FRAMES_PER_CHUNK)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 'a':
+			nAheadChunks = strtoul (optarg, 0, 0);
+#ifndef ARM_ALLOW_MULTI_CORE
+			if (nAheadChunks > 0)
+			{
+				Usage ();
+
+				return 1;
+			}
+#endif
+			break;
+
+		case 'e':
+#ifndef ARM_ALLOW_MULTI_CORE
+			Usage ();
+
+			return 1;
+#endif
+			bEffectsCore = TRUE;
+			break;
+
+		case 't':
+			fTailSecs = atof (optarg);
+			if (fTailSecs < 0.0)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 's':
+			VoiceStealing = CVoiceManager::GetVoiceStealing (optarg);
+			if (VoiceStealing >= VoiceStealingUnknown)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 'n':
+			bRetrigger = FALSE;
+			break;
+
+		case 'l':
+			nCullLevelDB = strtoul (optarg, 0, 0);
+			break;
+
+		default:
+			Usage ();
+
+			return 1;
+		}
+	}
+
+	// like effectscore=1 without renderahead=
+	if (   bEffectsCore
+	    && nAheadChunks == 0)
+	{
+		Usage ();
+
+		return 1;
+	}
+
+	if (argc - optind != 3)
+	{
+		Usage ();
+
+		return 1;
+	}
+
+	const char *pPatchFile = argv[optind];
+	const char *pMIDIFile  = argv[optind+1];
+	const char *pWaveFile  = argv[optind+2];
+
+	FATFS FileSystem;
+
+	CPatch Patch (pPatchFile, &FileSystem);
+	if (!Patch.Load ())
+	{
+		fprintf (stderr, "%s: Cannot load patch %s\n", FromMIDI2WAV, pPatchFile);
+
+		return 1;
+	}
+
+	CMIDICCMap CCMap (&FileSystem);
+	CCMap.Load ();				// optional
+
+	CMIDIFile MIDIFile;
+	if (!MIDIFile.Load (pMIDIFile))
+	{
+		fprintf (stderr, "%s: Cannot load MIDI file %s\n", FromMIDI2WAV, pMIDIFile);
+
+		return 1;
+	}
+
+	CWaveFile WaveFile;
+	if (!WaveFile.Create (pWaveFile, CSampleRate::Get ()))
+	{
+		fprintf (stderr, "%s: Cannot create %s\n", FromMIDI2WAV, pWaveFile);
+
+		return 1;
+	}
+
+	CVoiceManager *pVoiceManager = new CVoiceManager (CMemorySystem::Get ());
+	if (!pVoiceManager->Initialize ())
+	{
+		fprintf (stderr, "%s: Cannot initialize voice manager\n", FromMIDI2WAV);
+
+		return 1;
+	}
+	pVoiceManager->SetVoiceStealing (VoiceStealing, bRetrigger);
+	pVoiceManager->SetCullLevel (nCullLevelDB);
+
+	TRenderer Renderer;
+	Renderer.pPatch = &Patch;
+	Renderer.pVoiceManager = pVoiceManager;
+	Renderer.nSampleClock = 0;
+	Renderer.nChunkFrames = 0;
+
+	Renderer.PatchCompiler.Publish (&Patch);
+
+	// the chunks rendered ahead must fit into the ring
+	if (nAheadChunks > RENDER_RING_FRAMES / nChunkFrames)
+	{
+		nAheadChunks = RENDER_RING_FRAMES / nChunkFrames;
+	}
+	Renderer.nAheadFrames = nAheadChunks * nChunkFrames;
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	// CMiniSynthesizer::RenderFrames() does this before each chunk
+	pVoiceManager->SetEffectsCore (bEffectsCore);
+
+	if (nAheadChunks > 0)
+	{
+		pVoiceManager->StartRenderAhead (RenderAhead, &Renderer);
+	}
+#endif
+
+	// the volume is applied by the renderer already, like in CMiniSynthesizer
+	const int nMaxLevel = 32767-1;
+	const int nMinLevel = -32768+1;
+	CSampleConverter Converter (SampleFormatInt16, (float) nMaxLevel, 0, nMinLevel, nMaxLevel, FALSE);
+
+	unsigned nTotalFrames =
+		(unsigned) ((MIDIFile.GetDuration () + fTailSecs) * CSampleRate::Get () + 0.5);
+
+	std::chrono::steady_clock::duration RenderTime (0);
+
+	s16 Buffer[MAX_FRAMES_PER_CHUNK * 2];
+	unsigned nEvent = 0;
+	unsigned nFrame = 0;
+	unsigned nLateChunks = 0;			// the renderer was late
+	while (nFrame < nTotalFrames)
+	{
+		unsigned nChunk = nTotalFrames - nFrame;
+		if (nChunk > nChunkFrames)
+		{
+			nChunk = nChunkFrames;
+		}
+
+		auto StartTime = std::chrono::steady_clock::now ();
+
+		// post the events of this chunk and of the chunks rendered ahead after it,
+		// they apply at their exact frame
+		while (nEvent < MIDIFile.GetEventCount ())
+		{
+			const TMIDIEvent &Event = MIDIFile.GetEvent (nEvent);
+			u32 nTimestamp = (u32) (Event.fTime * CSampleRate::Get () + 0.5);
+			if (nTimestamp >= nFrame + nChunk + Renderer.nAheadFrames)
+			{
+				break;
+			}
+
+			HandleMessage (Event, nTimestamp, &Renderer, CCMap);
+
+			nEvent++;
+		}
+
+		// let the renderer start, now that its first events are known
+		__atomic_store_n (&Renderer.nChunkFrames, nChunkFrames, __ATOMIC_RELEASE);
+		CCoreSync::SendEvent ();
+
+		// convert the chunk like CMiniSynthesizer::GetChunk()
+		boolean bLate = FALSE;
+		s16 *pBuffer = Buffer;
+		for (unsigned nRest = nChunk; nRest > 0;)
+		{
+			if (   nAheadChunks == 0
+			    && Renderer.RenderRing.GetFilled () == 0)
+			{
+				RenderFrames (&Renderer, nRest);
+			}
+
+			const float *pLevelLeft;
+			const float *pLevelRight;
+			unsigned nFrames = Renderer.RenderRing.Peek (&pLevelLeft, &pLevelRight, nRest);
+			if (nFrames == 0)
+			{
+				// unlike GetChunk(), wait for the renderer, so that nothing is lost
+				bLate = TRUE;
+				CCoreSync::WaitForEvent ();
+
+				continue;
+			}
+
+			pBuffer = (s16 *) Converter.Convert (pLevelLeft, pLevelRight, nFrames, pBuffer);
+
+			Renderer.RenderRing.Consume (nFrames);
+
+			nFrame += nFrames;
+			nRest -= nFrames;
+		}
+
+		RenderTime += std::chrono::steady_clock::now () - StartTime;
+
+		if (bLate)
+		{
+			nLateChunks++;
+		}
+
+		if (!WaveFile.Write (Buffer, nChunk))
+		{
+			fprintf (stderr, "%s: Cannot write %s\n", FromMIDI2WAV, pWaveFile);
+
+			return 1;
+		}
+	}
+
+	delete pVoiceManager;
+
+	if (!WaveFile.Close ())
+	{
+		fprintf (stderr, "%s: Cannot write %s\n", FromMIDI2WAV, pWaveFile);
+
+		return 1;
+	}
+
+	double fAudioSecs = (double) nTotalFrames / CSampleRate::Get ();
+	double fRenderSecs = std::chrono::duration<double> (RenderTime).count ();
+
+	printf ("%u voices on %u cores, %u frames per chunk, %s backend\n",
+		VOICES, VOICES / VOICES_PER_CORE, nChunkFrames, VECTOR_BACKEND);
+	if (bEffectsCore)
+	{
+		printf ("Reverb on core %u\n", EFFECTS_CORE);
+	}
+	if (nAheadChunks > 0)
+	{
+		printf ("%u chunks rendered ahead on core %u, %u chunks were late\n",
+			nAheadChunks, RENDER_CORE, nLateChunks);
+	}
+	printf ("%.2f s audio rendered in %.3f s (%.1fx real time)\n",
+		fAudioSecs, fRenderSecs, fRenderSecs > 0.0 ? fAudioSecs / fRenderSecs : 0.0);
+	printf ("MIDI queue %u/%u, %u events lost\n", Renderer.EventQueue.GetHighWaterMark (),
+		EVENT_QUEUE_SIZE, Renderer.EventQueue.GetOverflowCount ());
+
+	return 0;
+}
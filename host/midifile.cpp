@@ -0,0 +1,344 @@
+//
+// midifile.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "midifile.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <assert.h>
+
+#define TEMPO_DEFAULT		500000		// microseconds per quarter note (120 BPM)
+
+static unsigned GetBE (const u8 *pData, unsigned nBytes)
+{
+	unsigned nValue = 0;
+	while (nBytes-- > 0)
+	{
+		nValue = nValue << 8 | *pData++;
+	}
+
+	return nValue;
+}
+
+CMIDIFile::CMIDIFile (void)
+:	m_nDivision (0),
+	m_fDuration (0.0)
+{
+}
+
+CMIDIFile::~CMIDIFile (void)
+{
+}
+
+boolean CMIDIFile::Load (const char *pFileName)
+{
+	assert (pFileName != 0);
+
+	m_TrackEvents.clear ();
+	m_Events.clear ();
+	m_fDuration = 0.0;
+
+	FILE *pFile = fopen (pFileName, "rb");
+	if (pFile == 0)
+	{
+		return FALSE;
+	}
+
+	std::vector<u8> Data;
+	u8 Buffer[4096];
+	size_t nRead;
+	while ((nRead = fread (Buffer, 1, sizeof Buffer, pFile)) > 0)
+	{
+		Data.insert (Data.end (), Buffer, Buffer + nRead);
+	}
+
+	fclose (pFile);
+
+	const u8 *pData = Data.data ();
+	const u8 *pEnd = pData + Data.size ();
+
+	// header chunk
+	if (   pEnd - pData < 14
+	    || memcmp (pData, "MThd", 4) != 0
+	    || GetBE (pData+4, 4) < 6)
+	{
+		return FALSE;
+	}
+
+	unsigned nFormat = GetBE (pData+8, 2);
+	unsigned nTracks = GetBE (pData+10, 2);
+	m_nDivision = GetBE (pData+12, 2);
+	if (   nFormat > 1
+	    || m_nDivision == 0)
+	{
+		return FALSE;
+	}
+
+	pData += 8 + GetBE (pData+4, 4);
+
+	// track chunks (unknown chunks are skipped)
+	unsigned nTrack = 0;
+	while (   nTrack < nTracks
+	       && pEnd - pData >= 8)
+	{
+		unsigned nSize = GetBE (pData+4, 4);
+		if (nSize > (unsigned) (pEnd - pData - 8))
+		{
+			return FALSE;
+		}
+
+		if (memcmp (pData, "MTrk", 4) == 0)
+		{
+			if (!ParseTrack (pData+8, nSize, nTrack++))
+			{
+				return FALSE;
+			}
+		}
+
+		pData += 8 + nSize;
+	}
+
+	// merge the tracks and convert the ticks to seconds
+	std::sort (m_TrackEvents.begin (), m_TrackEvents.end (),
+		   [] (const TTrackEvent &a, const TTrackEvent &b)
+		   {
+			if (a.nTick != b.nTick)
+			{
+				return a.nTick < b.nTick;
+			}
+
+			if (a.nTrack != b.nTrack)
+			{
+				return a.nTrack < b.nTrack;
+			}
+
+			return a.nSequence < b.nSequence;
+		   });
+
+	double fSecondsPerTick;
+	boolean bSMPTE = !!(m_nDivision & 0x8000);
+	if (bSMPTE)
+	{
+		unsigned nFramesPerSecond = -(s8) (m_nDivision >> 8);
+		unsigned nTicksPerFrame = m_nDivision & 0xFF;
+		if (   nFramesPerSecond == 0
+		    || nTicksPerFrame == 0)
+		{
+			return FALSE;
+		}
+
+		fSecondsPerTick = 1.0 / (nFramesPerSecond * nTicksPerFrame);
+	}
+	else
+	{
+		fSecondsPerTick = TEMPO_DEFAULT / 1e6 / m_nDivision;
+	}
+
+	u64 nLastTick = 0;
+	double fTime = 0.0;
+	for (auto &Event : m_TrackEvents)
+	{
+		fTime += (Event.nTick - nLastTick) * fSecondsPerTick;
+		nLastTick = Event.nTick;
+
+		if (Event.nTempo != 0)
+		{
+			if (!bSMPTE)
+			{
+				fSecondsPerTick = Event.nTempo / 1e6 / m_nDivision;
+			}
+
+			continue;
+		}
+
+		if (Event.nLength == 0)		// end of track
+		{
+			continue;
+		}
+
+		TMIDIEvent MIDIEvent;
+		MIDIEvent.fTime = fTime;
+		memcpy (MIDIEvent.Message, Event.Message, sizeof MIDIEvent.Message);
+		MIDIEvent.nLength = Event.nLength;
+
+		m_Events.push_back (MIDIEvent);
+	}
+
+	m_fDuration = fTime;
+
+	m_TrackEvents.clear ();
+
+	return TRUE;
+}
+
+const TMIDIEvent &CMIDIFile::GetEvent (unsigned nIndex) const
+{
+	assert (nIndex < m_Events.size ());
+	return m_Events[nIndex];
+}
+
+boolean CMIDIFile::ParseTrack (const u8 *pData, unsigned nSize, unsigned nTrack)
+{
+	const u8 *pEnd = pData + nSize;
+
+	u64 nTick = 0;
+	unsigned nSequence = 0;
+	u8 ucRunningStatus = 0;
+
+	while (pData < pEnd)
+	{
+		unsigned nDelta;
+		if (!ReadVarLength (pData, pEnd, &nDelta))
+		{
+			return FALSE;
+		}
+
+		nTick += nDelta;
+
+		if (pData >= pEnd)
+		{
+			return FALSE;
+		}
+
+		TTrackEvent Event;
+		Event.nTick = nTick;
+		Event.nTrack = nTrack;
+		Event.nSequence = nSequence++;
+		Event.nTempo = 0;
+		Event.nLength = 0;
+
+		u8 ucStatus = *pData;
+		if (ucStatus == 0xFF)			// meta event
+		{
+			if (pEnd - pData < 2)
+			{
+				return FALSE;
+			}
+
+			u8 ucType = pData[1];
+			pData += 2;
+
+			unsigned nLength;
+			if (   !ReadVarLength (pData, pEnd, &nLength)
+			    || nLength > (unsigned) (pEnd - pData))
+			{
+				return FALSE;
+			}
+
+			if (ucType == 0x2F)		// end of track
+			{
+				m_TrackEvents.push_back (Event);
+
+				return TRUE;
+			}
+
+			if (   ucType == 0x51		// set tempo
+			    && nLength == 3)
+			{
+				Event.nTempo = GetBE (pData, 3);
+				if (Event.nTempo != 0)
+				{
+					m_TrackEvents.push_back (Event);
+				}
+			}
+
+			pData += nLength;
+
+			continue;
+		}
+
+		if (   ucStatus == 0xF0			// system exclusive (ignored)
+		    || ucStatus == 0xF7)
+		{
+			pData++;
+
+			unsigned nLength;
+			if (   !ReadVarLength (pData, pEnd, &nLength)
+			    || nLength > (unsigned) (pEnd - pData))
+			{
+				return FALSE;
+			}
+
+			pData += nLength;
+			ucRunningStatus = 0;
+
+			continue;
+		}
+
+		if (ucStatus & 0x80)
+		{
+			if (ucStatus >= 0xF0)		// no system common messages in SMF
+			{
+				return FALSE;
+			}
+
+			ucRunningStatus = ucStatus;
+			pData++;
+		}
+		else if (ucRunningStatus == 0)
+		{
+			return FALSE;
+		}
+
+		Event.Message[0] = ucRunningStatus;
+
+		// program change and channel pressure have one data byte
+		u8 ucType = ucRunningStatus >> 4;
+		unsigned nDataBytes = ucType == 0xC || ucType == 0xD ? 1 : 2;
+		if ((unsigned) (pEnd - pData) < nDataBytes)
+		{
+			return FALSE;
+		}
+
+		Event.Message[1] = pData[0] & 0x7F;
+		Event.Message[2] = nDataBytes == 2 ? pData[1] & 0x7F : 0;
+		Event.nLength = 1 + nDataBytes;
+		pData += nDataBytes;
+
+		m_TrackEvents.push_back (Event);
+	}
+
+	return TRUE;					// missing end of track is tolerated
+}
+
+boolean CMIDIFile::ReadVarLength (const u8 *&pData, const u8 *pEnd, unsigned *pValue)
+{
+	assert (pValue != 0);
+
+	unsigned nValue = 0;
+	for (unsigned i = 0; i < 4; i++)
+	{
+		if (pData >= pEnd)
+		{
+			return FALSE;
+		}
+
+		u8 ucByte = *pData++;
+		nValue = nValue << 7 | (ucByte & 0x7F);
+
+		if (!(ucByte & 0x80))
+		{
+			*pValue = nValue;
+
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
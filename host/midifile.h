@@ -0,0 +1,72 @@
+//
+// midifile.h
+//
+// Reads a Standard MIDI File (format 0 or 1) into a time-ordered event list
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _midifile_h
+#define _midifile_h
+
+#include <circle/types.h>
+#include <vector>
+
+struct TMIDIEvent
+{
+	double	fTime;			// seconds from start of file
+	u8	Message[3];		// channel message (status byte first)
+	unsigned nLength;
+};
+
+class CMIDIFile
+{
+public:
+	CMIDIFile (void);
+	~CMIDIFile (void);
+
+	boolean Load (const char *pFileName);	// returns FALSE on error
+
+	unsigned GetEventCount (void) const		{ return m_Events.size (); }
+	const TMIDIEvent &GetEvent (unsigned nIndex) const;
+
+	double GetDuration (void) const			{ return m_fDuration; }
+
+private:
+	struct TTrackEvent
+	{
+		u64	nTick;
+		unsigned nTrack;	// both keep the order of simultaneous events
+		unsigned nSequence;
+		unsigned nTempo;	// microseconds per quarter note, 0 if no tempo change
+		u8	Message[3];
+		unsigned nLength;
+	};
+
+	boolean ParseTrack (const u8 *pData, unsigned nSize, unsigned nTrack);
+
+	static boolean ReadVarLength (const u8 *&pData, const u8 *pEnd, unsigned *pValue);
+
+private:
+	unsigned m_nDivision;
+
+	std::vector<TTrackEvent> m_TrackEvents;
+	std::vector<TMIDIEvent> m_Events;
+
+	double m_fDuration;
+};
+
+#endif
@@ -0,0 +1,481 @@
+//
+// synthtest.cpp
+//
+// Test program for the host build of the MiniSynth Pi sound engine (see make check)
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "filtertable.h"
+#include "samplerate.h"
+#include <circle/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+#define MIDI_DIVISION		480		// ticks per quarter note
+#define MIDI_TEMPO_DEFAULT	500000		// microseconds per quarter note (120 bpm)
+
+#define SONG_CHORDS		40
+#define SONG_CHORD_TICKS	480
+#define SONG_CC_STEPS		8		// per chord
+
+#define ONSET_NOTES		300
+#define ONSET_TEMPO		461538		// 130 bpm, a tick is 46.15 frames at 48000 Hz
+#define ONSET_KEY		69
+#define ONSET_SILENCE		100		// frames before an onset
+#define ONSET_TOLERANCE		1		// frames
+
+#define FILTER_CUTOFF_STEPS	6570		// over the cutoff range (0.0137 percent)
+#define FILTER_FREQ_STEPS	200		// logarithmic over 20 Hz..20 kHz
+#define FILTER_FLOOR_DB		-60.0		// the error below this level is ignored
+#define FILTER_ERROR_DB		0.6		// maximum error (see Filter())
+
+static const char FromSynthTest[] = "synthtest";
+
+static void Usage (void)
+{
+	fprintf (stderr,
+		 "Usage: %s song output.mid\n"
+		 "       %s onsets output.mid\n"
+		 "       %s checkonsets input.wav\n"
+		 "       %s filter [max dB]\n\n"
+		 "song\t\twrites a test song with chords and MIDI CCs\n"
+		 "onsets\t\twrites single notes at odd frames for checkonsets\n"
+		 "checkonsets\tchecks, that the notes start at their frame (+/- %u),\n"
+		 "\t\twhen they have been rendered with test/onsets.txt\n"
+		 "filter\t\tchecks the response error of the interpolated filter coefficients\n"
+		 "\t\tat each sample rate (default max %.2f dB)\n",
+		 FromSynthTest, FromSynthTest, FromSynthTest, FromSynthTest, ONSET_TOLERANCE,
+		 FILTER_ERROR_DB);
+}
+
+static u32 s_nRandSeed;
+
+// reproducible on every host
+static unsigned Random (unsigned nRange)
+{
+	s_nRandSeed = s_nRandSeed * 1103515245 + 12345;
+
+	return (s_nRandSeed >> 16) % nRange;
+}
+
+struct TSongEvent
+{
+	unsigned nTick;
+	u8	 Message[3];
+};
+
+static void WriteVarLength (std::vector<u8> *pData, unsigned nValue)
+{
+	u8 Buffer[5];
+	unsigned nLength = 0;
+	do
+	{
+		Buffer[nLength++] = nValue & 0x7F;
+		nValue >>= 7;
+	}
+	while (nValue != 0);
+
+	while (nLength-- > 1)
+	{
+		pData->push_back (Buffer[nLength] | 0x80);
+	}
+	pData->push_back (Buffer[0]);
+}
+
+static void WriteBE (std::vector<u8> *pData, unsigned nValue, unsigned nBytes)
+{
+	while (nBytes-- > 0)
+	{
+		pData->push_back ((u8) (nValue >> (nBytes * 8)));
+	}
+}
+
+// writes a format 0 Standard MIDI File, the events of one tick keep their order
+static boolean WriteMIDIFile (const char *pFileName, std::vector<TSongEvent> &rEvents,
+			      unsigned nTempo = MIDI_TEMPO_DEFAULT)
+{
+	std::stable_sort (rEvents.begin (), rEvents.end (),
+			  [] (const TSongEvent &rEvent1, const TSongEvent &rEvent2)
+			  { return rEvent1.nTick < rEvent2.nTick; });
+
+	std::vector<u8> Track;
+	if (nTempo != MIDI_TEMPO_DEFAULT)
+	{
+		static const u8 SetTempo[] = {0x00, 0xFF, 0x51, 0x03};
+		Track.insert (Track.end (), SetTempo, SetTempo + sizeof SetTempo);
+		WriteBE (&Track, nTempo, 3);
+	}
+
+	unsigned nLastTick = 0;
+	for (auto &rEvent : rEvents)
+	{
+		WriteVarLength (&Track, rEvent.nTick - nLastTick);
+		Track.insert (Track.end (), rEvent.Message, rEvent.Message + 3);
+
+		nLastTick = rEvent.nTick;
+	}
+
+	static const u8 EndOfTrack[] = {0x00, 0xFF, 0x2F, 0x00};
+	Track.insert (Track.end (), EndOfTrack, EndOfTrack + sizeof EndOfTrack);
+
+	std::vector<u8> Data;
+	Data.insert (Data.end (), "MThd", "MThd" + 4);
+	WriteBE (&Data, 6, 4);
+	WriteBE (&Data, 0, 2);				// format
+	WriteBE (&Data, 1, 2);				// tracks
+	WriteBE (&Data, MIDI_DIVISION, 2);
+	Data.insert (Data.end (), "MTrk", "MTrk" + 4);
+	WriteBE (&Data, Track.size (), 4);
+	Data.insert (Data.end (), Track.begin (), Track.end ());
+
+	FILE *pFile = fopen (pFileName, "wb");
+	if (pFile == 0)
+	{
+		return FALSE;
+	}
+
+	boolean bResult = fwrite (Data.data (), Data.size (), 1, pFile) == 1;
+
+	if (fclose (pFile) != 0)
+	{
+		bResult = FALSE;
+	}
+
+	return bResult;
+}
+
+static void AddEvent (std::vector<TSongEvent> *pEvents, unsigned nTick, u8 ucStatus,
+		      u8 ucParam1, u8 ucParam2)
+{
+	TSongEvent Event = {nTick, {ucStatus, ucParam1, ucParam2}};
+
+	pEvents->push_back (Event);
+}
+
+// chords of 3 to 8 notes, which overlap the next chord sometimes, so that voices
+// are stolen, with cutoff and resonance sweeps (MIDI CC 74 and 71 in midi-cc.txt)
+static int Song (const char *pMIDIFile)
+{
+	static const unsigned Intervals[] = {0, 3, 4, 7, 10, 12, 14, 16, 19, 24};
+
+	std::vector<TSongEvent> Events;
+
+	s_nRandSeed = 1;
+
+	for (unsigned nChord = 0; nChord < SONG_CHORDS; nChord++)
+	{
+		unsigned nTick = nChord * SONG_CHORD_TICKS;
+
+		unsigned nLength = SONG_CHORD_TICKS - 60;
+		if (Random (4) == 0)
+		{
+			nLength *= 3;
+		}
+
+		unsigned nNotes = 3 + Random (6);
+		unsigned nRoot = 36 + Random (24);
+		for (unsigned i = 0; i < nNotes; i++)
+		{
+			u8 ucKey = nRoot + Intervals[Random (sizeof Intervals / sizeof Intervals[0])];
+
+			AddEvent (&Events, nTick + Random (8), 0x90, ucKey, 40 + Random (88));
+			AddEvent (&Events, nTick + nLength, 0x80, ucKey, 0);
+		}
+
+		for (unsigned i = 0; i < SONG_CC_STEPS; i++)
+		{
+			AddEvent (&Events, nTick + i * SONG_CHORD_TICKS / SONG_CC_STEPS,
+				  0xB0, 74, 40 + (nChord * 7 + i * 5) % 80);
+		}
+
+		AddEvent (&Events, nTick + SONG_CHORD_TICKS/2, 0xB0, 71, Random (100));
+	}
+
+	if (!WriteMIDIFile (pMIDIFile, Events))
+	{
+		fprintf (stderr, "%s: Cannot write %s\n", FromSynthTest, pMIDIFile);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+// single notes of 15 to 30 ms with 40 to 110 ms in between, returns their ticks
+static void GetOnsetTicks (std::vector<unsigned> *pTicks, std::vector<unsigned> *pLengths = 0)
+{
+	s_nRandSeed = 7;
+
+	unsigned nTick = 0;
+	for (unsigned i = 0; i < ONSET_NOTES; i++)
+	{
+		nTick += 40 + Random (75);
+		pTicks->push_back (nTick);
+
+		unsigned nLength = 15 + Random (16);
+		if (pLengths != 0)
+		{
+			pLengths->push_back (nLength);
+		}
+	}
+}
+
+static int Onsets (const char *pMIDIFile)
+{
+	std::vector<unsigned> Ticks, Lengths;
+	GetOnsetTicks (&Ticks, &Lengths);
+
+	std::vector<TSongEvent> Events;
+	for (unsigned i = 0; i < Ticks.size (); i++)
+	{
+		AddEvent (&Events, Ticks[i], 0x90, ONSET_KEY, 100);
+		AddEvent (&Events, Ticks[i] + Lengths[i], 0x80, ONSET_KEY, 0);
+	}
+
+	if (!WriteMIDIFile (pMIDIFile, Events, ONSET_TEMPO))
+	{
+		fprintf (stderr, "%s: Cannot write %s\n", FromSynthTest, pMIDIFile);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+// reads the left channel of a WAV file written by CWaveFile, returns the sample rate or 0
+static unsigned ReadWaveFile (const char *pFileName, std::vector<s16> *pSamples)
+{
+	FILE *pFile = fopen (pFileName, "rb");
+	if (pFile == 0)
+	{
+		return 0;
+	}
+
+	u8 Header[44];
+	unsigned nSampleRate = 0;
+	if (   fread (Header, sizeof Header, 1, pFile) == 1
+	    && memcmp (Header, "RIFF", 4) == 0
+	    && memcmp (Header+8, "WAVEfmt ", 8) == 0
+	    && Header[22] == 2				// stereo
+	    && Header[34] == 16)			// bits per sample
+	{
+		nSampleRate = Header[24] | Header[25] << 8 | Header[26] << 16 | Header[27] << 24;
+
+		u8 Frame[4];
+		while (fread (Frame, sizeof Frame, 1, pFile) == 1)
+		{
+			pSamples->push_back ((s16) (Frame[0] | Frame[1] << 8));
+		}
+	}
+
+	fclose (pFile);
+
+	return nSampleRate;
+}
+
+// an onset is the first non-zero sample after ONSET_SILENCE zero samples
+static int CheckOnsets (const char *pWaveFile)
+{
+	std::vector<s16> Samples;
+	unsigned nSampleRate = ReadWaveFile (pWaveFile, &Samples);
+	if (nSampleRate == 0)
+	{
+		fprintf (stderr, "%s: Cannot read %s\n", FromSynthTest, pWaveFile);
+
+		return 1;
+	}
+
+	std::vector<unsigned> Ticks;
+	GetOnsetTicks (&Ticks);
+
+	unsigned nOnset = 0;
+	unsigned nSilence = 0;
+	int nMinError = 0;
+	int nMaxError = 0;
+	for (unsigned i = 0; i < Samples.size (); i++)
+	{
+		if (Samples[i] == 0)
+		{
+			nSilence++;
+
+			continue;
+		}
+
+		if (   nSilence >= ONSET_SILENCE
+		    && nOnset < Ticks.size ())
+		{
+			double fTime = (double) Ticks[nOnset] * ONSET_TEMPO / MIDI_DIVISION / 1000000.0;
+			int nError = (int) i - (int) (fTime * nSampleRate + 0.5);
+
+			if (   nOnset == 0
+			    || nError < nMinError)
+			{
+				nMinError = nError;
+			}
+			if (   nOnset == 0
+			    || nError > nMaxError)
+			{
+				nMaxError = nError;
+			}
+
+			nOnset++;
+		}
+
+		nSilence = 0;
+	}
+
+	printf ("%s: %u/%u onsets, error %d..%d frames\n", pWaveFile, nOnset,
+		(unsigned) Ticks.size (), nMinError, nMaxError);
+
+	if (   nOnset != Ticks.size ()
+	    || nMinError < -ONSET_TOLERANCE
+	    || nMaxError > ONSET_TOLERANCE)
+	{
+		fprintf (stderr, "%s: Note onsets do not match\n", FromSynthTest);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+// the magnitude response of the biquad in dB at fFrequency (in Hz)
+static double FilterResponse (const TFilterCoefficients &rCoeff, double fFrequency)
+{
+	std::complex<double> z1 = std::polar (1.0, -2.0*M_PI * fFrequency / CSampleRate::Get ());
+	std::complex<double> z2 = z1 * z1;
+
+	double B0_B2 = rCoeff.B0_B2;
+	double B1 = rCoeff.B1;
+	double A1 = rCoeff.A1;
+	double A2 = rCoeff.A2;
+
+	std::complex<double> H = (B0_B2 + B1*z1 + B0_B2*z2) / (1.0 + A1*z1 + A2*z2);
+
+	return 20.0 * log10 (std::abs (H));
+}
+
+// compares the response of the interpolated coefficients with the exact ones over the
+// cutoff range, where the exact response is above FILTER_FLOOR_DB. With 128 steps it is
+// largest next to the Nyquist limit (0.42 dB at 44100 Hz) and at the lowest cutoff at
+// 96000 Hz (0.5 dB), where the single-precision coefficients alone make the difference.
+static int Filter (double fMaxErrorDB)
+{
+	static const unsigned Resonances[] = {0, 20, 50, 80, 100};
+
+	CFilterTable *pTable = new CFilterTable;
+
+	double fWorstErrorDB = 0.0;
+	for (unsigned i = 0; CSampleRate::Supported[i] != 0; i++)
+	{
+		CSampleRate::Set (CSampleRate::Supported[i]);
+		pTable->Build ();
+
+		double fErrorDB = 0.0;
+		for (unsigned nResonance : Resonances)
+		{
+			const TFilterCoefficients *pRow = pTable->GetRow (nResonance);
+
+			for (unsigned nStep = 0; nStep <= FILTER_CUTOFF_STEPS; nStep++)
+			{
+				float fCutoffFrequency =   FILTER_CUTOFF_MIN
+							 + nStep * (FILTER_CUTOFF_MAX - FILTER_CUTOFF_MIN)
+							   / FILTER_CUTOFF_STEPS;
+
+				TFilterCoefficients Exact, Interpolated;
+				CFilterTable::CalculateCoefficients (fCutoffFrequency, nResonance, &Exact);
+				pTable->GetCoefficients (pRow, fCutoffFrequency, &Interpolated);
+
+				for (unsigned nFreq = 0; nFreq <= FILTER_FREQ_STEPS; nFreq++)
+				{
+					double fFrequency = 20.0 * pow (1000.0, (double) nFreq / FILTER_FREQ_STEPS);
+					if (fFrequency >= CSampleRate::Get () / 2)
+					{
+						break;
+					}
+
+					double fExactDB = FilterResponse (Exact, fFrequency);
+					if (fExactDB < FILTER_FLOOR_DB)
+					{
+						continue;
+					}
+
+					double fDiffDB = fabs (FilterResponse (Interpolated, fFrequency) - fExactDB);
+					if (fDiffDB > fErrorDB)
+					{
+						fErrorDB = fDiffDB;
+					}
+				}
+			}
+		}
+
+		printf ("%u Hz: filter response error up to %.3f dB\n", CSampleRate::Get (), fErrorDB);
+
+		if (fErrorDB > fWorstErrorDB)
+		{
+			fWorstErrorDB = fErrorDB;
+		}
+	}
+
+	delete pTable;
+
+	if (fWorstErrorDB > fMaxErrorDB)
+	{
+		fprintf (stderr, "%s: Filter error above %.2f dB (FILTER_TABLE_SIZE %u)\n",
+			 FromSynthTest, fMaxErrorDB, FILTER_TABLE_SIZE);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	if (   argc == 3
+	    && strcmp (argv[1], "song") == 0)
+	{
+		return Song (argv[2]);
+	}
+
+	if (   argc == 3
+	    && strcmp (argv[1], "onsets") == 0)
+	{
+		return Onsets (argv[2]);
+	}
+
+	if (   argc == 3
+	    && strcmp (argv[1], "checkonsets") == 0)
+	{
+		return CheckOnsets (argv[2]);
+	}
+
+	if (   (argc == 2 || argc == 3)
+	    && strcmp (argv[1], "filter") == 0)
+	{
+		return Filter (argc == 3 ? atof (argv[2]) : FILTER_ERROR_DB);
+	}
+
+	Usage ();
+
+	return 1;
+}
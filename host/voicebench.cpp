@@ -0,0 +1,667 @@
+//
+// voicebench.cpp
+//
+// Measures how many voices of a MiniSynth Pi patch one CPU core renders in real time
+// at each sample rate, the cost and the pitch accuracy of the oscillators, or the
+// critical path per chunk, when the cores render the voice groups of a chord test
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "voicebank.h"
+#include "voicemanager.h"
+#include "oscillator.h"
+#include "patch.h"
+#include "patchcompiler.h"
+#include "samplerate.h"
+#include "simd.h"
+#include "config.h"
+#include <fatfs/ff.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#define SECS_DEFAULT		10.0		// of audio per run
+#define RUNS_DEFAULT		5		// the fastest run is reported
+
+#define FIRST_KEY_NUMBER	48		// the voices play a chord from here
+#define KEY_STEP		5
+
+#define OSCILLATOR_FREQUENCY	440.0f		// of the first voice
+#define LFO_FREQUENCY		5.0f
+
+#define PITCH_ERROR_CENTS	0.01		// maximum error of the measured pitch
+
+#define CHORDS			40		// of 3 to 8 notes
+#define CHORD_SECS		0.5		// from one chord to the next
+#define CHORD_HOLD_SECS		0.4
+#define CHORD_CULL_LEVEL	0.001f		// of the VCA envelope (-60 dB)
+#define CHUNK_FRAMES_DEFAULT	256
+
+static const char FromVoiceBench[] = "voicebench";
+
+// returns the seconds of the fastest run
+static double Benchmark (const CPatch *pPatch, unsigned nBlocks, unsigned nRuns)
+{
+	TCompiledPatch CompiledPatch;
+	CPatchCompiler::Compile (pPatch, &CompiledPatch);
+
+	u32 nVoices = (1U << VOICES_PER_CORE) - 1;
+
+	static float Buffer[FRAMES_PER_BLOCK];
+
+	double fBestSecs = 0.0;
+	for (unsigned nRun = 0; nRun < nRuns; nRun++)
+	{
+		CVoiceBank *pVoiceBank = new CVoiceBank;
+		pVoiceBank->SetPatch (&CompiledPatch);
+
+		for (unsigned nVoice = 0; nVoice < VOICES_PER_CORE; nVoice++)
+		{
+			pVoiceBank->NoteOn (nVoice, FIRST_KEY_NUMBER + nVoice*KEY_STEP % 48, 100);
+		}
+
+		auto StartTime = std::chrono::steady_clock::now ();
+
+		for (unsigned nBlock = 0; nBlock < nBlocks; nBlock++)
+		{
+			for (unsigned i = 0; i < FRAMES_PER_BLOCK; i++)
+			{
+				Buffer[i] = 0.0;
+			}
+
+			pVoiceBank->RenderBlock (nVoices, Buffer, FRAMES_PER_BLOCK);
+		}
+
+		double fRenderSecs = std::chrono::duration<double> (
+			std::chrono::steady_clock::now () - StartTime).count ();
+		if (   nRun == 0
+		    || fRenderSecs < fBestSecs)
+		{
+			fBestSecs = fRenderSecs;
+		}
+
+		delete pVoiceBank;
+	}
+
+	return fBestSecs;
+}
+
+// returns the seconds of the fastest run over all voices of a bank,
+// with an LFO as modulator, if bModulation is TRUE
+static double BenchmarkOscillator (TWaveform Waveform, boolean bModulation,
+				   unsigned nBlocks, unsigned nRuns)
+{
+	TOscillatorParameters Parameters;
+	COscillator::CompileParameters (Waveform, 1.0f, 0.0f, bModulation ? 0.5f : 0.0f,
+					&Parameters);
+
+	TOscillatorParameters LFOParameters;
+	COscillator::CompileParameters (WaveformSine, LFO_FREQUENCY, 0.0f, 0.0f, &LFOParameters);
+
+	static float Buffer[FRAMES_PER_BLOCK * VECTOR_LANES];
+	static float Modulation[FRAMES_PER_BLOCK * VECTOR_LANES];
+
+	double fBestSecs = 0.0;
+	for (unsigned nRun = 0; nRun < nRuns; nRun++)
+	{
+		COscillator *pOscillator = new COscillator;
+		pOscillator->SetParameters (&Parameters);
+
+		COscillator *pLFO = new COscillator (TRUE);
+		pLFO->SetParameters (&LFOParameters);
+
+		for (unsigned nVoice = 0; nVoice < VOICES_PER_CORE; nVoice++)
+		{
+			// the voices play different pitches, like a chord
+			pOscillator->SetFrequency (nVoice, OSCILLATOR_FREQUENCY
+							   * exp2f (nVoice * KEY_STEP % 48 / 12.0f));
+		}
+
+		auto StartTime = std::chrono::steady_clock::now ();
+
+		for (unsigned nBlock = 0; nBlock < nBlocks; nBlock++)
+		{
+			for (unsigned nGroup = 0; nGroup < VOICE_GROUPS; nGroup++)
+			{
+				const float *pModulation = 0;
+				if (bModulation)
+				{
+					pLFO->RenderBlock (nGroup, Modulation, FRAMES_PER_BLOCK);
+					pModulation = Modulation;
+				}
+
+				pOscillator->RenderBlock (nGroup, Buffer, FRAMES_PER_BLOCK, pModulation);
+			}
+		}
+
+		double fRenderSecs = std::chrono::duration<double> (
+			std::chrono::steady_clock::now () - StartTime).count ();
+		if (   nRun == 0
+		    || fRenderSecs < fBestSecs)
+		{
+			fBestSecs = fRenderSecs;
+		}
+
+		delete pLFO;
+		delete pOscillator;
+	}
+
+	return fBestSecs;
+}
+
+// Renders a sawtooth at each frequency and measures its pitch from the rising zero
+// crossings in the middle of the ramp (with linear interpolation between the samples).
+// Returns FALSE, if one of them is off by more than PITCH_ERROR_CENTS.
+static boolean CheckPitch (unsigned nBlocks)
+{
+	static const float Frequencies[] = {55.0f, 440.0f, 880.0f, 1760.0f, 3520.0f, 4186.0f};
+
+	TOscillatorParameters Parameters;
+	COscillator::CompileParameters (WaveformSawtooth, 1.0f, 0.0f, 0.0f, &Parameters);
+
+	static float Buffer[FRAMES_PER_BLOCK * VECTOR_LANES];
+
+	boolean bResult = TRUE;
+	for (float fFrequency : Frequencies)
+	{
+		COscillator *pOscillator = new COscillator;
+		pOscillator->SetParameters (&Parameters);
+		pOscillator->SetFrequency (0, fFrequency);
+
+		unsigned nCrossings = 0;
+		double fFirstCrossing = 0.0;
+		double fLastCrossing = 0.0;
+		float fPrevLevel = 0.0f;
+		for (unsigned nBlock = 0; nBlock < nBlocks; nBlock++)
+		{
+			pOscillator->RenderBlock (0, Buffer, FRAMES_PER_BLOCK);
+
+			for (unsigned i = 0; i < FRAMES_PER_BLOCK; i++)
+			{
+				float fLevel = Buffer[i * VECTOR_LANES];	// voice 0
+				unsigned nFrame = nBlock * FRAMES_PER_BLOCK + i;
+
+				if (   nFrame > 0
+				    && fPrevLevel < 0.0f
+				    && fLevel >= 0.0f)
+				{
+					fLastCrossing = nFrame - fLevel / (fLevel - fPrevLevel);
+					if (nCrossings++ == 0)
+					{
+						fFirstCrossing = fLastCrossing;
+					}
+				}
+
+				fPrevLevel = fLevel;
+			}
+		}
+
+		delete pOscillator;
+
+		double fMeasured = 0.0;
+		if (nCrossings > 1)
+		{
+			fMeasured = (nCrossings - 1) * CSampleRate::Get ()
+				    / (fLastCrossing - fFirstCrossing);
+		}
+
+		double fErrorCents = fMeasured > 0.0 ? 1200.0 * log2 (fMeasured / fFrequency) : 1200.0;
+
+		printf ("%6.0f Hz: %+.4f cents\n", fFrequency, fErrorCents);
+
+		if (fabs (fErrorCents) > PITCH_ERROR_CENTS)
+		{
+			bResult = FALSE;
+		}
+	}
+
+	if (!bResult)
+	{
+		fprintf (stderr, "%s: Pitch error above %.2f cents\n", FromVoiceBench, PITCH_ERROR_CENTS);
+	}
+
+	return bResult;
+}
+
+static void ReportOscillators (unsigned nBlocks, unsigned nRuns)
+{
+	static const struct
+	{
+		const char *pName;
+		TWaveform Waveform;
+		boolean bModulation;
+	}
+	Oscillators[] =
+	{
+		{"sine", WaveformSine, FALSE},
+		{"square", WaveformSquare, FALSE},
+		{"sawtooth", WaveformSawtooth, FALSE},
+		{"triangle", WaveformTriangle, FALSE},
+		{"pulse 12%", WaveformPulse12, FALSE},
+		{"pulse 25%", WaveformPulse25, FALSE},
+		{"noise", WaveformWhiteNoise, FALSE},
+		{"saw + LFO", WaveformSawtooth, TRUE}
+	};
+
+	double fVoiceSamples = (double) nBlocks * FRAMES_PER_BLOCK * VOICE_LANES;
+
+	for (auto &rOscillator : Oscillators)
+	{
+		double fBestSecs = BenchmarkOscillator (rOscillator.Waveform, rOscillator.bModulation,
+							nBlocks, nRuns);
+
+		printf ("%-10s %6.2f ns per voice and sample\n",
+			rOscillator.pName, fBestSecs * 1e9 / fVoiceSamples);
+	}
+}
+
+// reproducible on every host
+static unsigned Random (unsigned nRange)
+{
+	static u32 nSeed = 2;
+
+	nSeed = nSeed * 1103515245 + 12345;
+
+	return (nSeed >> 16) % nRange;
+}
+
+static double Percentile (std::vector<double> Values, unsigned nPercent)
+{
+	std::sort (Values.begin (), Values.end ());
+
+	return Values[(Values.size () - 1) * nPercent / 100];
+}
+
+// Plays chords on the voice banks, which get the first free voice (like CVoiceManager,
+// when the groups fill up), measures the render time of each group per chunk and
+// compares the critical path of the old schedule, where each core rendered the groups
+// of its own bank, with the cores claiming the groups from the list one after the other.
+// Returns FALSE, if claiming is slower on average.
+static boolean ReportChords (const CPatch *pPatch, unsigned nChunkFrames)
+{
+	TCompiledPatch CompiledPatch;
+	CPatchCompiler::Compile (pPatch, &CompiledPatch);
+
+	CVoiceBank *pVoiceBank[VOICE_BANKS];
+	for (unsigned i = 0; i < VOICE_BANKS; i++)
+	{
+		pVoiceBank[i] = new CVoiceBank;
+		pVoiceBank[i]->SetPatch (&CompiledPatch);
+	}
+
+	static const unsigned Intervals[] = {0, 3, 4, 7, 10, 12, 14, 16, 19, 24};
+
+	u32 nActiveVoices = 0;
+	u32 nHeldVoices = 0;
+
+	std::vector<double> Static, Dynamic;
+
+	static float Buffer[FRAMES_PER_BLOCK];
+
+	unsigned nChordFrames = (unsigned) (CHORD_SECS * CSampleRate::Get ());
+	unsigned nHoldFrames = (unsigned) (CHORD_HOLD_SECS * CSampleRate::Get ());
+	unsigned nTotalFrames = CHORDS * nChordFrames;
+	for (unsigned nFrame = 0; nFrame < nTotalFrames; nFrame += nChunkFrames)
+	{
+		// the events apply at the start of the chunk
+		unsigned nChordFrame = nFrame % nChordFrames;
+		if (nChordFrame < nChunkFrames)
+		{
+			unsigned nNotes = 3 + Random (6);
+			unsigned nRoot = 36 + Random (24);
+			for (unsigned i = 0; i < nNotes; i++)
+			{
+				if (~nActiveVoices == 0)
+				{
+					break;
+				}
+
+				unsigned nVoice = __builtin_ctz (~nActiveVoices);
+				if (nVoice >= VOICES)
+				{
+					break;
+				}
+
+				pVoiceBank[nVoice / VOICES_PER_CORE]->NoteOn (nVoice % VOICES_PER_CORE,
+					nRoot + Intervals[Random (sizeof Intervals / sizeof Intervals[0])], 100);
+
+				nActiveVoices |= 1U << nVoice;
+				nHeldVoices |= 1U << nVoice;
+			}
+		}
+		else if (   nChordFrame >= nHoldFrames
+			 && nChordFrame < nHoldFrames + nChunkFrames)
+		{
+			for (unsigned nVoice = 0; nVoice < VOICES; nVoice++)
+			{
+				if (nHeldVoices & (1U << nVoice))
+				{
+					pVoiceBank[nVoice / VOICES_PER_CORE]->NoteOff (nVoice % VOICES_PER_CORE);
+				}
+			}
+
+			nHeldVoices = 0;
+		}
+
+		double fBankTime[VOICE_BANKS] = {0.0};
+		double fCoreTime[VOICE_BANKS] = {0.0};
+		for (unsigned nGroup = 0; nGroup < GROUPS; nGroup++)
+		{
+			unsigned nBank = nGroup / VOICE_GROUPS;
+			unsigned nFirst = nGroup % VOICE_GROUPS * VECTOR_LANES;
+
+			u32 nVoices = nActiveVoices >> (nBank * VOICES_PER_CORE);
+			nVoices &= ((1U << VOICES_PER_CORE) - 1) & (((1U << VECTOR_LANES) - 1) << nFirst);
+			if (nVoices == 0)
+			{
+				continue;
+			}
+
+			auto StartTime = std::chrono::steady_clock::now ();
+
+			for (unsigned nRest = nChunkFrames; nRest > 0;)
+			{
+				unsigned nBlock = nRest < FRAMES_PER_BLOCK ? nRest : FRAMES_PER_BLOCK;
+
+				pVoiceBank[nBank]->RenderBlock (nVoices, Buffer, nBlock);
+
+				nRest -= nBlock;
+			}
+
+			double fTime = std::chrono::duration<double> (
+				std::chrono::steady_clock::now () - StartTime).count ();
+
+			fBankTime[nBank] += fTime;
+
+			// the next group is claimed by the core, which becomes free first
+			*std::min_element (fCoreTime, fCoreTime + VOICE_BANKS) += fTime;
+
+			for (unsigned i = 0; i < FRAMES_PER_BLOCK; i++)
+			{
+				Buffer[i] = 0.0f;
+			}
+		}
+
+		Static.push_back (*std::max_element (fBankTime, fBankTime + VOICE_BANKS) * 1e6);
+		Dynamic.push_back (*std::max_element (fCoreTime, fCoreTime + VOICE_BANKS) * 1e6);
+
+		// free the voices, which have become silent
+		for (unsigned nVoice = 0; nVoice < VOICES; nVoice++)
+		{
+			if (   (nActiveVoices & ~nHeldVoices & (1U << nVoice))
+			    && !pVoiceBank[nVoice / VOICES_PER_CORE]->IsAudible (nVoice % VOICES_PER_CORE,
+										 CHORD_CULL_LEVEL))
+			{
+				nActiveVoices &= ~(1U << nVoice);
+			}
+		}
+	}
+
+	for (unsigned i = 0; i < VOICE_BANKS; i++)
+	{
+		delete pVoiceBank[i];
+	}
+
+	double fStaticMean = 0.0;
+	double fDynamicMean = 0.0;
+	for (unsigned i = 0; i < Static.size (); i++)
+	{
+		fStaticMean += Static[i];
+		fDynamicMean += Dynamic[i];
+	}
+	fStaticMean /= Static.size ();
+	fDynamicMean /= Dynamic.size ();
+
+	printf ("Critical path per chunk of %u frames, mean / p99:\n"
+		"per bank  %7.1f / %7.1f us\n"
+		"claimed   %7.1f / %7.1f us\n",
+		nChunkFrames, fStaticMean, Percentile (Static, 99),
+		fDynamicMean, Percentile (Dynamic, 99));
+
+	if (fDynamicMean > fStaticMean)
+	{
+		fprintf (stderr, "%s: Claiming the groups is slower\n", FromVoiceBench);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void Usage (void)
+{
+	fprintf (stderr,
+		 "Usage: %s [-t seconds] [-r runs] [-s rate] patch.txt\n"
+		 "       %s -o [-t seconds] [-r runs] [-s rate]\n"
+		 "       %s -p [-t seconds] [-s rate]\n"
+		 "       %s -g [-c frames] [-s rate] patch.txt\n\n"
+		 "-t seconds\taudio rendered per run (default %.1f)\n"
+		 "-r runs\t\tnumber of runs, the fastest one is reported (default %u)\n"
+		 "-s rate\t\tsample rate: 32000, 44100, 48000 or 96000 (default all)\n"
+		 "-o\t\tmeasures the oscillators by waveform instead (at 48000 Hz by default)\n"
+		 "-p\t\tchecks the pitch of the oscillators (max error %.2f cents)\n"
+		 "-g\t\tmeasures the critical path per chunk of a chord test on %u cores\n"
+		 "-c frames\tframes per chunk with -g (1..%u, default %u)\n\n"
+		 "All %u voices of one voice bank hold a note while they are rendered.\n",
+		 FromVoiceBench, FromVoiceBench, FromVoiceBench, FromVoiceBench, SECS_DEFAULT,
+		 RUNS_DEFAULT, PITCH_ERROR_CENTS, VOICE_BANKS, MAX_FRAMES_PER_CHUNK, CHUNK_FRAMES_DEFAULT, VOICES_PER_CORE);
+}
+
+int main (int argc, char **argv)
+{
+	double fSecs = SECS_DEFAULT;
+	unsigned nRuns = RUNS_DEFAULT;
+	unsigned nSampleRate = 0;			// all
+	boolean bOscillators = FALSE;
+	boolean bPitch = FALSE;
+	boolean bChords = FALSE;
+	unsigned nChunkFrames = CHUNK_FRAMES_DEFAULT;
+
+	int nOption;
+	while ((nOption = getopt (argc, argv, "t:r:s:opgc:")) != -1)
+	{
+		switch (nOption)
+		{
+		case 't':
+			fSecs = atof (optarg);
+			if (fSecs <= 0.0)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 'r':
+			nRuns = strtoul (optarg, 0, 0);
+			if (nRuns == 0)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 's':
+			nSampleRate = strtoul (optarg, 0, 0);
+			if (!CSampleRate::IsSupported (nSampleRate))
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		case 'o':
+			bOscillators = TRUE;
+			break;
+
+		case 'p':
+			bPitch = TRUE;
+			break;
+
+		case 'g':
+			bChords = TRUE;
+			break;
+
+		case 'c':
+			nChunkFrames = strtoul (optarg, 0, 0);
+			if (   nChunkFrames == 0
+			    || nChunkFrames > MAX_FRAMES_PER_CHUNK)
+			{
+				Usage ();
+
+				return 1;
+			}
+			break;
+
+		default:
+			Usage ();
+
+			return 1;
+		}
+	}
+
+	if (bPitch)
+	{
+		if (argc - optind != 0)
+		{
+			Usage ();
+
+			return 1;
+		}
+
+		boolean bResult = TRUE;
+		for (unsigned i = 0; CSampleRate::Supported[i] != 0; i++)
+		{
+			if (   nSampleRate != 0
+			    && nSampleRate != CSampleRate::Supported[i])
+			{
+				continue;
+			}
+
+			CSampleRate::Set (CSampleRate::Supported[i]);
+
+			unsigned nBlocks = (unsigned) (fSecs * CSampleRate::Get () / FRAMES_PER_BLOCK + 0.5);
+
+			printf ("Sawtooth pitch at %u Hz over %.1f s:\n", CSampleRate::Get (), fSecs);
+
+			if (!CheckPitch (nBlocks))
+			{
+				bResult = FALSE;
+			}
+		}
+
+		return bResult ? 0 : 1;
+	}
+
+	if (bOscillators)
+	{
+		if (argc - optind != 0)
+		{
+			Usage ();
+
+			return 1;
+		}
+
+		if (nSampleRate != 0)
+		{
+			CSampleRate::Set (nSampleRate);
+		}
+
+		unsigned nBlocks = (unsigned) (fSecs * CSampleRate::Get () / FRAMES_PER_BLOCK + 0.5);
+		if (nBlocks == 0)
+		{
+			nBlocks = 1;
+		}
+
+		printf ("%u oscillators, %s backend with %u lanes, %u Hz\n",
+			VOICE_LANES, VECTOR_BACKEND, VECTOR_LANES, CSampleRate::Get ());
+
+		ReportOscillators (nBlocks, nRuns);
+
+		return 0;
+	}
+
+	if (argc - optind != 1)
+	{
+		Usage ();
+
+		return 1;
+	}
+
+	const char *pPatchFile = argv[optind];
+
+	FATFS FileSystem;
+
+	CPatch Patch (pPatchFile, &FileSystem);
+	if (!Patch.Load ())
+	{
+		fprintf (stderr, "%s: Cannot load patch %s\n", FromVoiceBench, pPatchFile);
+
+		return 1;
+	}
+
+	if (bChords)
+	{
+		if (nSampleRate != 0)
+		{
+			CSampleRate::Set (nSampleRate);
+		}
+
+		printf ("%u voices on %u cores, %s backend with %u lanes (%u groups)\n",
+			VOICES, VOICE_BANKS, VECTOR_BACKEND, VECTOR_LANES, GROUPS);
+
+		return ReportChords (&Patch, nChunkFrames) ? 0 : 1;
+	}
+
+	printf ("%u voices per core, %s backend with %u lanes (%u groups)\n",
+		VOICES_PER_CORE, VECTOR_BACKEND, VECTOR_LANES, VOICE_GROUPS);
+
+	for (unsigned i = 0; CSampleRate::Supported[i] != 0; i++)
+	{
+		if (   nSampleRate != 0
+		    && nSampleRate != CSampleRate::Supported[i])
+		{
+			continue;
+		}
+
+		CSampleRate::Set (CSampleRate::Supported[i]);
+
+		unsigned nBlocks = (unsigned) (fSecs * CSampleRate::Get () / FRAMES_PER_BLOCK + 0.5);
+		if (nBlocks == 0)
+		{
+			nBlocks = 1;
+		}
+
+		double fBestSecs = Benchmark (&Patch, nBlocks, nRuns);
+
+		double fAudioSecs = (double) nBlocks * FRAMES_PER_BLOCK / CSampleRate::Get ();
+		double fVoiceSamples = (double) nBlocks * FRAMES_PER_BLOCK * VOICES_PER_CORE;
+
+		printf ("%u Hz: %.2f s audio rendered in %.3f s, %.1f ns per voice and sample, "
+			"%.0f voices per core at real time\n",
+			CSampleRate::Get (), fAudioSecs, fBestSecs, fBestSecs * 1e9 / fVoiceSamples,
+			fBestSecs > 0.0 ? VOICES_PER_CORE * fAudioSecs / fBestSecs : 0.0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+//
+// wavefile.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "wavefile.h"
+#include <string.h>
+#include <assert.h>
+
+#define CHANNELS		2
+#define BYTES_PER_SAMPLE	2
+
+static void SetLE (u8 *pBuffer, unsigned nValue, unsigned nBytes)
+{
+	while (nBytes-- > 0)
+	{
+		*pBuffer++ = (u8) nValue;
+		nValue >>= 8;
+	}
+}
+
+CWaveFile::CWaveFile (void)
+:	m_pFile (0),
+	m_nSampleRate (0),
+	m_nFrames (0)
+{
+}
+
+CWaveFile::~CWaveFile (void)
+{
+	if (m_pFile != 0)
+	{
+		Close ();
+	}
+}
+
+boolean CWaveFile::Create (const char *pFileName, unsigned nSampleRate)
+{
+	assert (pFileName != 0);
+	assert (m_pFile == 0);
+
+	m_pFile = fopen (pFileName, "wb");
+	if (m_pFile == 0)
+	{
+		return FALSE;
+	}
+
+	m_nSampleRate = nSampleRate;
+	m_nFrames = 0;
+
+	return WriteHeader ();
+}
+
+boolean CWaveFile::Write (const s16 *pBuffer, unsigned nFrames)
+{
+	assert (m_pFile != 0);
+	assert (pBuffer != 0);
+
+	// WAV is little endian
+	u8 Buffer[1024 * CHANNELS * BYTES_PER_SAMPLE];
+	unsigned nSamples = nFrames * CHANNELS;
+	while (nSamples > 0)
+	{
+		unsigned nCount = nSamples;
+		if (nCount > sizeof Buffer / BYTES_PER_SAMPLE)
+		{
+			nCount = sizeof Buffer / BYTES_PER_SAMPLE;
+		}
+
+		for (unsigned i = 0; i < nCount; i++)
+		{
+			SetLE (&Buffer[i * BYTES_PER_SAMPLE], (u16) *pBuffer++, BYTES_PER_SAMPLE);
+		}
+
+		if (fwrite (Buffer, BYTES_PER_SAMPLE, nCount, m_pFile) != nCount)
+		{
+			return FALSE;
+		}
+
+		nSamples -= nCount;
+	}
+
+	m_nFrames += nFrames;
+
+	return TRUE;
+}
+
+boolean CWaveFile::Close (void)
+{
+	assert (m_pFile != 0);
+
+	boolean bResult =    fseek (m_pFile, 0, SEEK_SET) == 0
+			  && WriteHeader ();
+
+	if (fclose (m_pFile) != 0)
+	{
+		bResult = FALSE;
+	}
+
+	m_pFile = 0;
+
+	return bResult;
+}
+
+boolean CWaveFile::WriteHeader (void)
+{
+	assert (m_pFile != 0);
+
+	unsigned nDataSize = m_nFrames * CHANNELS * BYTES_PER_SAMPLE;
+
+	u8 Header[44];
+	memcpy (Header, "RIFF", 4);
+	SetLE (Header+4, 36 + nDataSize, 4);
+	memcpy (Header+8, "WAVEfmt ", 8);
+	SetLE (Header+16, 16, 4);					// fmt chunk size
+	SetLE (Header+20, 1, 2);					// PCM
+	SetLE (Header+22, CHANNELS, 2);
+	SetLE (Header+24, m_nSampleRate, 4);
+	SetLE (Header+28, m_nSampleRate * CHANNELS * BYTES_PER_SAMPLE, 4);
+	SetLE (Header+32, CHANNELS * BYTES_PER_SAMPLE, 2);		// block align
+	SetLE (Header+34, BYTES_PER_SAMPLE * 8, 2);			// bits per sample
+	memcpy (Header+36, "data", 4);
+	SetLE (Header+40, nDataSize, 4);
+
+	return fwrite (Header, sizeof Header, 1, m_pFile) == 1;
+}
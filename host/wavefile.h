@@ -0,0 +1,52 @@
+//
+// wavefile.h
+//
+// Writes a 16-bit PCM stereo WAV file
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _wavefile_h
+#define _wavefile_h
+
+#include <circle/types.h>
+#include <stdio.h>
+
+class CWaveFile
+{
+public:
+	CWaveFile (void);
+	~CWaveFile (void);			// closes the file, if still open
+
+	boolean Create (const char *pFileName, unsigned nSampleRate);
+
+	// pBuffer contains nFrames interleaved left/right samples
+	boolean Write (const s16 *pBuffer, unsigned nFrames);
+
+	boolean Close (void);			// updates the header
+
+	unsigned GetFrames (void) const		{ return m_nFrames; }
+
+private:
+	boolean WriteHeader (void);
+
+private:
+	FILE *m_pFile;
+	unsigned m_nSampleRate;
+	unsigned m_nFrames;
+};
+
+#endif
@@ -2,7 +2,7 @@
 // amplifier.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -20,40 +20,67 @@
 #include "amplifier.h"
 #include <assert.h>
 
-CAmplifier::CAmplifier (CSynthModule *pInput, CSynthModule *pModulator, CSynthModule *pEnvelope)
-:	m_pInput (pInput),
-	m_pModulator (pModulator),
-	m_pEnvelope (pEnvelope),
-	m_fModulationVolume (0.0),
-	m_fOutputLevel (0.0)
+CAmplifier::CAmplifier (void)
+:	m_pParameters (0)
 {
+	for (unsigned i = 0; i < VOICE_LANES; i++)
+	{
+		m_fGain[i] = 0.0;
+	}
 }
 
 CAmplifier::~CAmplifier (void)
 {
-	m_pInput = 0;
-	m_pModulator = 0;
-	m_pEnvelope = 0;
+	m_pParameters = 0;
 }
 
-void CAmplifier::SetModulationVolume (float fVolume)
+void CAmplifier::SetParameters (const TAmplifierParameters *pParameters)
 {
-	assert (0.0 <= fVolume && fVolume <= 1.0);
-	m_fModulationVolume = fVolume;
+	assert (pParameters != 0);
+	assert (0.0 <= pParameters->fModulationVolume && pParameters->fModulationVolume <= 1.0);
+	m_pParameters = pParameters;
 }
 
-void CAmplifier::NextSample (void)
+void CAmplifier::RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames,
+			      const float *pInput, const float *pModulation, const float *pEnvelope)
 {
-	assert (m_pInput != 0);
-	assert (m_pModulator != 0);
-	assert (m_pEnvelope != 0);
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+	assert (pInput != 0);
+	assert (pModulation != 0);
+	assert (pEnvelope != 0);
 
-	m_fOutputLevel  = m_pInput->GetOutputLevel ();
-	m_fOutputLevel *= 1.0 + m_pModulator->GetOutputLevel ()*m_fModulationVolume;
-	m_fOutputLevel *= m_pEnvelope->GetOutputLevel ();
-}
+	assert (m_pParameters != 0);
+	TVector ModulationVolume = VectorSet (m_pParameters->fModulationVolume);
 
-float CAmplifier::GetOutputLevel (void) const
-{
-	return m_fOutputLevel;
+	unsigned nFirst = nGroup * VECTOR_LANES;
+	TVector Gain = VectorLoad (&m_fGain[nFirst]);
+	CControlRate ControlRate = m_ControlRate[nGroup];
+
+	for (unsigned i = 0; i < nFrames;)
+	{
+		float fReciprocal;
+		unsigned nPiece = ControlRate.NextPiece (nFrames - i, &fReciprocal);
+
+		// the gain is calculated at the end of the piece only
+		unsigned nEnd = (i + nPiece-1) * VECTOR_LANES;
+		TVector Target = VectorMul (VectorAdd (VectorSet (1.0f),
+						       VectorMul (VectorLoad (&pModulation[nEnd]),
+								  ModulationVolume)),
+					    VectorLoad (&pEnvelope[nEnd]));
+
+		TVector Step = VectorMul (VectorSub (Target, Gain), VectorSet (fReciprocal));
+		for (unsigned j = 0; j < nPiece; j++)
+		{
+			Gain = VectorAdd (Gain, Step);
+			VectorStore (&pBuffer[i * VECTOR_LANES],
+				     VectorMul (VectorLoad (&pInput[i * VECTOR_LANES]), Gain));
+			i++;
+		}
+
+		Gain = Target;
+	}
+
+	VectorStore (&m_fGain[nFirst], Gain);
+	m_ControlRate[nGroup] = ControlRate;
 }
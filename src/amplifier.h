@@ -2,7 +2,7 @@
 // amplifier.h
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -20,27 +20,37 @@
 #ifndef _amplifier_h
 #define _amplifier_h
 
-#include "synthmodule.h"
+#include "controlrate.h"
+#include "simd.h"
+#include "config.h"
 
-class CAmplifier : public CSynthModule
+struct TAmplifierParameters
+{
+	float fModulationVolume;			// [0.0, 1.0]
+};
+
+// Holds the amplifiers of the VOICES_PER_CORE voices of a voice bank (nVoice is the
+// index in the bank) in arrays over the voices for each field. They are rendered
+// in groups of VECTOR_LANES voices (nGroup, see COscillator).
+
+class CAmplifier
 {
 public:
-	CAmplifier (CSynthModule *pInput, CSynthModule *pModulator, CSynthModule *pEnvelope);
+	CAmplifier (void);
 	~CAmplifier (void);
 
-	void SetModulationVolume (float fVolume);	// [0.0, 1.0]
+	// pParameters must stay valid, while the amplifiers are rendered
+	void SetParameters (const TAmplifierParameters *pParameters);
 
-	void NextSample (void);
-	float GetOutputLevel (void) const;		// returns [-1.0, 1.0]
+	// pInput, pModulation and pEnvelope are the output blocks of the input modules
+	void RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames, const float *pInput,
+			  const float *pModulation, const float *pEnvelope);
 
 private:
-	CSynthModule *m_pInput;
-	CSynthModule *m_pModulator;
-	CSynthModule *m_pEnvelope;
-
-	float m_fModulationVolume;
+	const TAmplifierParameters *m_pParameters;
 
-	float m_fOutputLevel;
+	CControlRate m_ControlRate[VOICE_GROUPS];
+	float m_fGain[VOICE_LANES];			// at the end of the last piece
 };
 
 #endif
@@ -2,7 +2,7 @@
 // config.h
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2022  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -20,13 +20,59 @@
 #ifndef _config_h
 #define _config_h
 
-#define SAMPLE_RATE		48000		// overall system clock
+#define SAMPLE_RATE_DEFAULT	48000		// overall system clock (see samplerate=)
 
+#define FRAMES_PER_BLOCK	64		// samples rendered at once by the modules
+#define MAX_FRAMES_PER_CHUNK	2048		// rendered at once by all cores, larger chunks are split
+
+#ifndef CHUNK_FRAMES
+	#define CHUNK_FRAMES	1024		// output chunk of PWM and I2S (see chunksize=)
+#endif
+#define MIN_CHUNK_FRAMES	32		// chunksize= must be in [MIN_CHUNK_FRAMES, MAX_FRAMES_PER_CHUNK]
+
+#ifndef CONTROL_RATE_SAMPLES
+	#define CONTROL_RATE_SAMPLES 16		// LFOs, EGs, cutoff and gain are calculated every n samples
+#endif
+
+#ifndef FILTER_TABLE_SIZE
+	#define FILTER_TABLE_SIZE 128		// cutoff steps in the filter coefficient table
+#endif
+
+#ifndef EVENT_QUEUE_SIZE
+	#define EVENT_QUEUE_SIZE 256		// MIDI events waiting for the renderer (power of 2)
+#endif
+
+#ifndef RENDER_AHEAD_CHUNKS
+	#define RENDER_AHEAD_CHUNKS 0		// rendered ahead on a secondary core (0 = in GetChunk(), see renderahead=)
+#endif
+
+#ifndef RENDER_RING_FRAMES
+	#define RENDER_RING_FRAMES 8192		// max. frames rendered ahead (power of 2)
+#endif
+
+#ifndef VOICE_FADE_MS
+	#define VOICE_FADE_MS	2		// fade-out of a stolen voice before its new note
+#endif
+
+#ifndef VOICE_CULL_DB
+	#define VOICE_CULL_DB	60		// release tails below -n dBFS are culled (0 = off)
+#endif
+
+#ifndef REVERB_IDLE_DB
+	#define REVERB_IDLE_DB	100		// the reverb tail is cut below -n dBFS, when there is no input
+#endif
+
+#ifndef CACHE_LINE_SIZE
+	#define CACHE_LINE_SIZE	64		// data shared between cores is padded to this
+#endif
+
+#ifndef VOICES_PER_CORE
 #if RASPPI >= 2
 	#define VOICES_PER_CORE	6		// polyphonic voices per CPU core
 #else
 	#define VOICES_PER_CORE	4		// polyphonic voices (1 core only)
 #endif
+#endif
 
 #define VELOCITY_DEFAULT	80		// for PC keyboard (max. 127)
 
@@ -35,7 +81,7 @@
 #define DRIVE			"SD:"		// drive to use
 
 // configurable options
-#define LAST_NOTE_PRIORITY			// last note priority polyphony
+#define LAST_NOTE_PRIORITY			// steal a voice, if all are in use (see voicesteal=)
 
 #define DAC_I2C_ADDRESS		0		// I2C slave address of the DAC (0 for auto probing)
 
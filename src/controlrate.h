@@ -0,0 +1,71 @@
+//
+// controlrate.h
+//
+// Divides the audio stream into control periods of CONTROL_RATE_SAMPLES frames
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _controlrate_h
+#define _controlrate_h
+
+#include "config.h"
+#include <assert.h>
+
+// A module working at control rate calculates its exact output value at the
+// end of each piece only, and interpolates linearly from the previous value to
+// it. A piece ends at the end of a control period or at the end of the block.
+// All modules of a voice are rendered with the same block sizes, so that their
+// control periods stay aligned, even though each module has its own clock.
+
+class CControlRate
+{
+public:
+	CControlRate (void)
+	:	m_nRemaining (0)
+	{
+	}
+
+	// returns the length of the next piece (<= nFrames) and its reciprocal
+	unsigned NextPiece (unsigned nFrames, float *pReciprocal)
+	{
+		assert (nFrames > 0);
+		assert (pReciprocal != 0);
+
+		if (m_nRemaining == 0)
+		{
+			m_nRemaining = CONTROL_RATE_SAMPLES;
+		}
+
+		unsigned nPiece = m_nRemaining;
+		if (nPiece > nFrames)
+		{
+			nPiece = nFrames;
+		}
+
+		m_nRemaining -= nPiece;
+
+		*pReciprocal =   nPiece == CONTROL_RATE_SAMPLES
+			       ? 1.0f / CONTROL_RATE_SAMPLES : 1.0f / nPiece;
+
+		return nPiece;
+	}
+
+private:
+	unsigned m_nRemaining;			// frames left in the current control period
+};
+
+#endif
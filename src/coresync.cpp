@@ -0,0 +1,149 @@
+//
+// coresync.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "coresync.h"
+#include <circle/synchronize.h>
+#include <assert.h>
+
+#ifdef HOST_BUILD
+	#include <mutex>
+	#include <condition_variable>
+
+	// emulates the event register of each core with a global event counter
+	static volatile u32 s_nEventCount = 0;
+	static thread_local u32 s_nEventSeen = 0;
+
+	static volatile unsigned s_nWaiters = 0;
+	static std::mutex s_EventMutex;
+	static std::condition_variable s_EventCondition;
+#endif
+
+CCoreSync::CCoreSync (void)
+{
+	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	{
+		m_Core[nCore].nStatus = CoreStatusInit;
+	}
+}
+
+CCoreSync::~CCoreSync (void)
+{
+}
+
+void CCoreSync::Kick (unsigned nCore)
+{
+	assert (GetStatus (nCore) == CoreStatusIdle);
+	SetStatus (nCore, CoreStatusBusy);
+}
+
+void CCoreSync::WaitForIdle (unsigned nCore)
+{
+	while (GetStatus (nCore) != CoreStatusIdle)
+	{
+		WaitForEvent ();
+	}
+}
+
+void CCoreSync::Exit (unsigned nCore)
+{
+	assert (GetStatus (nCore) == CoreStatusIdle);
+	SetStatus (nCore, CoreStatusExit);
+
+	while (GetStatus (nCore) == CoreStatusExit)
+	{
+		WaitForEvent ();
+	}
+}
+
+boolean CCoreSync::WaitForKick (unsigned nCore)
+{
+	SetStatus (nCore, CoreStatusIdle);		// ready to be kicked
+
+	TCoreStatus Status;
+	while ((Status = GetStatus (nCore)) == CoreStatusIdle)
+	{
+		WaitForEvent ();
+	}
+
+	if (Status == CoreStatusExit)
+	{
+		SetStatus (nCore, CoreStatusUnknown);
+
+		return FALSE;
+	}
+
+	assert (Status == CoreStatusBusy);
+
+	return TRUE;
+}
+
+void CCoreSync::WaitForEvent (void)
+{
+#ifdef HOST_BUILD
+	std::unique_lock<std::mutex> Lock (s_EventMutex);
+
+	// SendEvent() takes the mutex, if it sees a waiter, and cannot notify too early
+	__atomic_add_fetch (&s_nWaiters, 1, __ATOMIC_SEQ_CST);
+
+	u32 nEventCount;
+	while ((nEventCount = __atomic_load_n (&s_nEventCount, __ATOMIC_SEQ_CST)) == s_nEventSeen)
+	{
+		s_EventCondition.wait (Lock);
+	}
+
+	s_nEventSeen = nEventCount;
+
+	__atomic_sub_fetch (&s_nWaiters, 1, __ATOMIC_RELAXED);
+#elif defined (ARM_ALLOW_MULTI_CORE)
+	asm volatile ("wfe");
+#endif
+}
+
+void CCoreSync::SendEvent (void)
+{
+#ifdef HOST_BUILD
+	__atomic_add_fetch (&s_nEventCount, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n (&s_nWaiters, __ATOMIC_SEQ_CST) > 0)
+	{
+		{
+			std::lock_guard<std::mutex> Lock (s_EventMutex);
+		}
+
+		s_EventCondition.notify_all ();
+	}
+#elif defined (ARM_ALLOW_MULTI_CORE)
+	DataSyncBarrier ();		// the data must be visible, when the other cores wake up
+	asm volatile ("sev");
+#endif
+}
+
+TCoreStatus CCoreSync::GetStatus (unsigned nCore) const
+{
+	assert (nCore < CORES);
+	return (TCoreStatus) __atomic_load_n (&m_Core[nCore].nStatus, __ATOMIC_ACQUIRE);
+}
+
+void CCoreSync::SetStatus (unsigned nCore, TCoreStatus Status)
+{
+	assert (nCore < CORES);
+	__atomic_store_n (&m_Core[nCore].nStatus, (unsigned) Status, __ATOMIC_RELEASE);
+
+	SendEvent ();
+}
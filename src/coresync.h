@@ -0,0 +1,87 @@
+//
+// coresync.h
+//
+// Synchronizes the secondary CPU cores with core 0
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _coresync_h
+#define _coresync_h
+
+#include <circle/sysconfig.h>
+#include <circle/types.h>
+#include "config.h"
+
+enum TCoreStatus
+{
+	CoreStatusInit,
+	CoreStatusIdle,
+	CoreStatusBusy,
+	CoreStatusExit,
+	CoreStatusUnknown
+};
+
+// Core 0 hands a job to a secondary core with Kick() and waits for its completion
+// with WaitForIdle(). The secondary cores loop on WaitForKick() and execute the job
+// each time it returns TRUE. The status of each core is held in its own cache line,
+// so that polling it does not disturb the other cores. Writing the status has
+// release semantics and reading it acquire semantics, so that the job data written
+// before Kick() is visible to the secondary core and its results are visible on
+// core 0 after WaitForIdle(). A secondary core, which runs a long job, may kick the
+// cores after it in the same way. This class does not depend on Circle (besides
+// types), so that it can be used with std::thread on a host too.
+//
+// A waiting core does not spin, but sleeps in WaitForEvent() until another core
+// calls SendEvent() (WFE and SEV on ARM, a condition variable on the host). Each
+// write to shared data, which another core may wait for, has to be followed by
+// SendEvent(). An event, which has been sent since the last return from
+// WaitForEvent() on this core, lets it return at once, so that it cannot be
+// missed between testing the data and waiting.
+
+class CCoreSync
+{
+public:
+	CCoreSync (void);
+	~CCoreSync (void);
+
+	// on core 0 (or the secondary core, which owns nCore)
+	void Kick (unsigned nCore);			// start the job on a secondary core
+	void WaitForIdle (unsigned nCore);		// wait until the core is ready again
+	void Exit (unsigned nCore);			// let the core return from WaitForKick()
+
+	// on a secondary core
+	boolean WaitForKick (unsigned nCore);		// returns FALSE, if the core has to exit
+
+	// called in a loop, which tests other shared data, until it has changed
+	static void WaitForEvent (void);		// may return without a reason
+	static void SendEvent (void);			// wakes all waiting cores
+
+private:
+	TCoreStatus GetStatus (unsigned nCore) const;
+	void SetStatus (unsigned nCore, TCoreStatus Status);
+
+private:
+	struct TCoreSlot
+	{
+		volatile unsigned nStatus;
+		u8 Padding[CACHE_LINE_SIZE - sizeof (unsigned)];
+	};
+
+	TCoreSlot m_Core[CORES];
+};
+
+#endif
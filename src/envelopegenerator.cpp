@@ -2,7 +2,7 @@
 // envelopegenerator.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -18,115 +18,255 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "envelopegenerator.h"
+#include "samplerate.h"
 #include "config.h"
+#include "math.h"
 #include <assert.h>
 
+// An exponential stage approaches a target beyond its end level, so that it
+// arrives there in the given time. The overshoot is relative to the distance
+// of the stage. The attack is slightly rounded, the decay and release curves
+// reach -60 dB of their distance at the end.
+#define ATTACK_OVERSHOOT	0.3f
+#define DECAY_OVERSHOOT		0.001f
+
 CEnvelopeGenerator::CEnvelopeGenerator (void)
-:	m_nAttackMsec (200),
-	m_nDecayMsec (5000),
-	m_fSustainLevel (0.5),
-	m_nReleaseMsec (500),
-	m_State (EnvelopeStateIdle),
-	m_nSampleCount (0),
-	m_fOutputLevel (0.0)
+:	m_pParameters (0)
 {
+	for (unsigned i = 0; i < VOICE_LANES; i++)
+	{
+		m_State[i] = EnvelopeStateIdle;
+		m_fVelocityLevel[i] = 1.0;
+		m_StageCurve[i] = EnvelopeCurveLinear;
+		m_nRemaining[i] = 0;
+		m_fEndLevel[i] = 0.0;
+		m_fIncrement[i] = 0.0;
+		m_fTarget[i] = 0.0;
+		m_fMultiplier[i] = 1.0;
+		m_fMultiplierPeriod[i] = 1.0;
+		m_fOutputLevel[i] = 0.0;
+	}
 }
 
 CEnvelopeGenerator::~CEnvelopeGenerator (void)
 {
+	m_pParameters = 0;
 }
 
-void CEnvelopeGenerator::SetAttack (unsigned nMilliSeconds)
+void CEnvelopeGenerator::SetParameters (const TEnvelopeParameters *pParameters)
 {
-	m_nAttackMsec = nMilliSeconds;
+	assert (pParameters != 0);
+	assert (pParameters->Curve < EnvelopeCurveUnknown);
+	m_pParameters = pParameters;
 }
 
-void CEnvelopeGenerator::SetDecay (unsigned nMilliSeconds)
+void CEnvelopeGenerator::NoteOn (unsigned nVoice, float fVelocityLevel)
 {
-	assert (nMilliSeconds > 0);
-	m_nDecayMsec = nMilliSeconds;
+	assert (nVoice < VOICES_PER_CORE);
+	assert (0.0 < fVelocityLevel && fVelocityLevel <= 1.0);
+	m_fVelocityLevel[nVoice] = fVelocityLevel;
+
+	m_fOutputLevel[nVoice] = 0.0;
+
+	assert (m_pParameters != 0);
+	StartStage (nVoice, EnvelopeStateAttack, m_fVelocityLevel[nVoice], m_pParameters->Attack);
 }
 
-void CEnvelopeGenerator::SetSustain (float fLevel)
+void CEnvelopeGenerator::NoteOff (unsigned nVoice)
 {
-	assert (0.0 <= fLevel && fLevel <= 1.0);
-	m_fSustainLevel = fLevel;
+	assert (nVoice < VOICES_PER_CORE);
 
+	if (m_State[nVoice] != EnvelopeStateIdle)
+	{
+		assert (m_pParameters != 0);
+		StartStage (nVoice, EnvelopeStateRelease, 0.0, m_pParameters->Release);
+	}
 }
 
-void CEnvelopeGenerator::SetRelease (unsigned nMilliSeconds)
+void CEnvelopeGenerator::Fade (unsigned nVoice, unsigned nSamples)
 {
-	m_nReleaseMsec = nMilliSeconds;
+	assert (nVoice < VOICES_PER_CORE);
+	assert (nSamples > 0);
+
+	if (m_State[nVoice] != EnvelopeStateIdle)
+	{
+		m_State[nVoice] = EnvelopeStateRelease;
+		m_StageCurve[nVoice] = EnvelopeCurveLinear;
+		m_fEndLevel[nVoice] = 0.0;
+		m_nRemaining[nVoice] = nSamples;
+		m_fIncrement[nVoice] = -m_fOutputLevel[nVoice] / nSamples;
+	}
 }
 
-void CEnvelopeGenerator::NoteOn (float fVelocityLevel)
+void CEnvelopeGenerator::Stop (unsigned nVoice)
 {
-	m_State = EnvelopeStateAttack;
+	assert (nVoice < VOICES_PER_CORE);
 
-	assert (0.0 < fVelocityLevel && fVelocityLevel <= 1.0);
-	m_fVelocityLevel = fVelocityLevel;
-
-	m_nSampleCount = 0;
-	m_fOutputLevel = 0.0;
+	m_State[nVoice] = EnvelopeStateIdle;
+	m_nRemaining[nVoice] = 0;
+	m_fOutputLevel[nVoice] = 0.0;
 }
 
-void CEnvelopeGenerator::NoteOff (void)
+TEnvelopeState CEnvelopeGenerator::GetState (unsigned nVoice) const
 {
-	if (m_State != EnvelopeStateIdle)
-	{
-		m_State = EnvelopeStateRelease;
-
-		m_nSampleCount = 0;
-		m_fReleaseLevel = m_fOutputLevel;
-	}
+	assert (nVoice < VOICES_PER_CORE);
+	return m_State[nVoice];
 }
 
-TEnvelopeState CEnvelopeGenerator::GetState (void) const
+unsigned CEnvelopeGenerator::GetRemaining (unsigned nVoice) const
 {
-	return m_State;
+	assert (nVoice < VOICES_PER_CORE);
+	return m_nRemaining[nVoice];
 }
 
-void CEnvelopeGenerator::NextSample (void)
+void CEnvelopeGenerator::RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames)
 {
-	if (++m_nSampleCount == 0)	// may wrap
-	{
-		m_nSampleCount = (unsigned) -1;
-	}
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+
+	unsigned nFirst = nGroup * VECTOR_LANES;
+	CControlRate ControlRate = m_ControlRate[nGroup];
 
-	switch (m_State)
+	for (unsigned i = 0; i < nFrames;)
 	{
-	case EnvelopeStateIdle:
-		break;
+		float fReciprocal;
+		unsigned nPiece = ControlRate.NextPiece (nFrames - i, &fReciprocal);
 
-	case EnvelopeStateAttack:
-		if (CalculateLevel (0.0, m_fVelocityLevel, m_nAttackMsec))
+		// the level is calculated at the end of the piece only, but a stage,
+		// which ends within the piece, splits it to keep the timing exact
+		boolean bSplit = FALSE;
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
 		{
-			m_nSampleCount = 0;
-			m_State = EnvelopeStateDecay;
+			unsigned nRemaining = m_nRemaining[nFirst + l];
+			if (   nRemaining != 0
+			    && nRemaining < nPiece)
+			{
+				bSplit = TRUE;
+			}
 		}
-		break;
 
-	case EnvelopeStateDecay:
-		if (CalculateLevel (m_fVelocityLevel, m_fSustainLevel*m_fVelocityLevel, m_nDecayMsec))
+		if (bSplit)
+		{
+			for (unsigned l = 0; l < VECTOR_LANES; l++)
+			{
+				RenderPiece (nFirst + l, &pBuffer[i * VECTOR_LANES + l], nPiece,
+					     fReciprocal);
+			}
+
+			i += nPiece;
+
+			continue;
+		}
+
+		TVector PrevLevel = VectorLoad (&m_fOutputLevel[nFirst]);
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
 		{
-			m_nSampleCount = 0;
-			m_State = EnvelopeStateSustain;
+			Advance (nFirst + l, nPiece);
 		}
+		TVector OutputLevel = VectorLoad (&m_fOutputLevel[nFirst]);
 
-		if (m_fOutputLevel == 0.0)
+		// interpolate up to the new level
+		TVector Level = PrevLevel;
+		TVector Step = VectorMul (VectorSub (OutputLevel, PrevLevel), VectorSet (fReciprocal));
+		for (unsigned j = 1; j < nPiece; j++)
 		{
-			m_State = EnvelopeStateIdle;
+			Level = VectorAdd (Level, Step);
+			VectorStore (&pBuffer[i++ * VECTOR_LANES], Level);
 		}
+
+		VectorStore (&pBuffer[i++ * VECTOR_LANES], OutputLevel);
+	}
+
+	m_ControlRate[nGroup] = ControlRate;
+}
+
+float CEnvelopeGenerator::GetOutputLevel (unsigned nVoice) const
+{
+	assert (nVoice < VOICES_PER_CORE);
+	return m_fOutputLevel[nVoice];
+}
+
+void CEnvelopeGenerator::CompileParameters (unsigned nAttackMs, unsigned nDecayMs,
+					    float fSustainLevel, unsigned nReleaseMs,
+					    TEnvelopeCurve Curve, TEnvelopeParameters *pResult)
+{
+	assert (nDecayMs > 0);
+	assert (0.0 <= fSustainLevel && fSustainLevel <= 1.0);
+	assert (Curve < EnvelopeCurveUnknown);
+	assert (pResult != 0);
+
+	CompileStage (nAttackMs, ATTACK_OVERSHOOT, &pResult->Attack);
+	CompileStage (nDecayMs, DECAY_OVERSHOOT, &pResult->Decay);
+	pResult->fSustainLevel = fSustainLevel;
+	CompileStage (nReleaseMs, DECAY_OVERSHOOT, &pResult->Release);
+	pResult->Curve = Curve;
+}
+
+void CEnvelopeGenerator::CompileStage (unsigned nMilliSeconds, float fOvershoot,
+				       TEnvelopeStage *pResult)
+{
+	assert (pResult != 0);
+
+	// the stage ends with the first sample at or after nMilliSeconds
+	unsigned nSamples = (nMilliSeconds * CSampleRate::Get () + 999) / 1000;
+	if (nSamples == 0)
+	{
+		nSamples = 1;
+	}
+
+	float fCoefficient = logf ((1.0f + fOvershoot) / fOvershoot) / nSamples;
+
+	pResult->nSamples = nSamples;
+	pResult->fOvershoot = fOvershoot;
+	pResult->fMultiplier = expf (-fCoefficient);
+	pResult->fMultiplierPeriod = expf (-fCoefficient * CONTROL_RATE_SAMPLES);
+}
+
+void CEnvelopeGenerator::StartStage (unsigned nVoice, TEnvelopeState State, float fEndLevel,
+				     const TEnvelopeStage &Stage)
+{
+	assert (nVoice < VOICE_LANES);
+	assert (m_pParameters != 0);
+
+	m_State[nVoice] = State;
+	m_StageCurve[nVoice] = m_pParameters->Curve;
+	m_fEndLevel[nVoice] = fEndLevel;
+
+	m_nRemaining[nVoice] = Stage.nSamples;
+
+	float fDistance = fEndLevel - m_fOutputLevel[nVoice];
+	if (m_StageCurve[nVoice] == EnvelopeCurveLinear)
+	{
+		m_fIncrement[nVoice] = fDistance / Stage.nSamples;
+	}
+	else
+	{
+		m_fTarget[nVoice] = fEndLevel + fDistance * Stage.fOvershoot;
+		m_fMultiplier[nVoice] = Stage.fMultiplier;
+		m_fMultiplierPeriod[nVoice] = Stage.fMultiplierPeriod;
+	}
+}
+
+void CEnvelopeGenerator::NextStage (unsigned nVoice)
+{
+	assert (nVoice < VOICE_LANES);
+
+	switch (m_State[nVoice])
+	{
+	case EnvelopeStateAttack:
+		assert (m_pParameters != 0);
+		StartStage (nVoice, EnvelopeStateDecay,
+			    m_pParameters->fSustainLevel*m_fVelocityLevel[nVoice],
+			    m_pParameters->Decay);
 		break;
 
-	case EnvelopeStateSustain:
+	case EnvelopeStateDecay:
+		m_State[nVoice] =   m_fOutputLevel[nVoice] != 0.0f
+				  ? EnvelopeStateSustain : EnvelopeStateIdle;
 		break;
 
 	case EnvelopeStateRelease:
-		if (CalculateLevel (m_fReleaseLevel, 0.0, m_nReleaseMsec))
-		{
-			m_State = EnvelopeStateIdle;
-		}
+		m_State[nVoice] = EnvelopeStateIdle;
 		break;
 
 	default:
@@ -135,35 +275,81 @@ void CEnvelopeGenerator::NextSample (void)
 	}
 }
 
-float CEnvelopeGenerator::GetOutputLevel (void) const
+void CEnvelopeGenerator::Advance (unsigned nVoice, unsigned nSamples)
 {
-	return m_fOutputLevel;
-}
+	assert (nVoice < VOICE_LANES);
 
-boolean CEnvelopeGenerator::CalculateLevel (float fPrevLevel, float fNextLevel, unsigned nMsDelay)
-{
-	if (nMsDelay == 0)
+	if (m_nRemaining[nVoice] == 0)			// idle or sustain
 	{
-		m_fOutputLevel = fNextLevel;
-
-		return TRUE;
+		return;
 	}
 
-	float fMsElapsed = m_nSampleCount * 1000.0 / SAMPLE_RATE;
-
-	m_fOutputLevel = fPrevLevel + (fNextLevel-fPrevLevel) * (fMsElapsed / nMsDelay);
-	if (m_fOutputLevel < 0.0)
+	assert (nSamples <= m_nRemaining[nVoice]);
+	m_nRemaining[nVoice] -= nSamples;
+	if (m_nRemaining[nVoice] == 0)
 	{
-		m_fOutputLevel = 0.0;
+		m_fOutputLevel[nVoice] = m_fEndLevel[nVoice];
 
-		return TRUE;
+		NextStage (nVoice);
+
+		return;
 	}
-	if (m_fOutputLevel > 1.0)
+
+	if (m_StageCurve[nVoice] == EnvelopeCurveLinear)
 	{
-		m_fOutputLevel = 1.0;
+		// calculated from the end, so that rounding errors do not accumulate
+		m_fOutputLevel[nVoice] =   m_fEndLevel[nVoice]
+					 - m_fIncrement[nVoice] * m_nRemaining[nVoice];
+	}
+	else
+	{
+		float fMultiplier = m_fMultiplierPeriod[nVoice];
+		if (nSamples != CONTROL_RATE_SAMPLES)
+		{
+			fMultiplier = m_fMultiplier[nVoice];
+			while (--nSamples > 0)
+			{
+				fMultiplier *= m_fMultiplier[nVoice];
+			}
+		}
 
-		return TRUE;
+		m_fOutputLevel[nVoice] =   m_fTarget[nVoice]
+					 + (m_fOutputLevel[nVoice] - m_fTarget[nVoice]) * fMultiplier;
 	}
+}
+
+void CEnvelopeGenerator::RenderPiece (unsigned nVoice, float *pBuffer, unsigned nFrames,
+				      float fReciprocal)
+{
+	assert (nVoice < VOICE_LANES);
+	assert (pBuffer != 0);
+
+	// the piece is split into segments, which end with a stage
+	unsigned i = 0;
+	while (nFrames > 0)
+	{
+		unsigned nSegment = nFrames;
+		float fSegmentReciprocal = fReciprocal;
+		if (   m_nRemaining[nVoice] != 0
+		    && m_nRemaining[nVoice] < nSegment)
+		{
+			nSegment = m_nRemaining[nVoice];
+			fSegmentReciprocal = 1.0f / nSegment;
+		}
+
+		float fPrevLevel = m_fOutputLevel[nVoice];
+		Advance (nVoice, nSegment);
 
-	return fMsElapsed >= nMsDelay;
+		float fLevel = fPrevLevel;
+		float fStep = (m_fOutputLevel[nVoice] - fPrevLevel) * fSegmentReciprocal;
+		for (unsigned j = 1; j < nSegment; j++)
+		{
+			fLevel += fStep;
+			pBuffer[i++ * VECTOR_LANES] = fLevel;
+		}
+
+		pBuffer[i++ * VECTOR_LANES] = m_fOutputLevel[nVoice];
+
+		nFrames -= nSegment;
+	}
 }
@@ -4,7 +4,7 @@
 // ADSR envelope generator
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,7 +22,9 @@
 #ifndef _envelopegenerator_h
 #define _envelopegenerator_h
 
-#include "synthmodule.h"
+#include "controlrate.h"
+#include "simd.h"
+#include "config.h"
 #include <circle/types.h>
 
 enum TEnvelopeState
@@ -35,42 +37,93 @@ enum TEnvelopeState
 	EnvelopeStateUnknown
 };
 
-class CEnvelopeGenerator : public CSynthModule
+enum TEnvelopeCurve
+{
+	EnvelopeCurveLinear,
+	EnvelopeCurveExponential,
+	EnvelopeCurveUnknown
+};
+
+struct TEnvelopeStage
+{
+	unsigned nSamples;				// length (>= 1)
+	float fOvershoot;				// of the target (exponential)
+	float fMultiplier;				// per sample (exponential)
+	float fMultiplierPeriod;			// per control period (exponential)
+};
+
+struct TEnvelopeParameters
+{
+	TEnvelopeStage Attack;
+	TEnvelopeStage Decay;
+	float fSustainLevel;				// [0.0, 1.0]
+	TEnvelopeStage Release;
+	TEnvelopeCurve Curve;				// applies from the next stage on
+};
+
+// Holds the envelope generators of the VOICES_PER_CORE voices of a voice bank
+// (nVoice is the index in the bank) in arrays over the voices for each field.
+// They are rendered in groups of VECTOR_LANES voices (nGroup, see COscillator).
+
+class CEnvelopeGenerator
 {
 public:
 	CEnvelopeGenerator (void);
 	~CEnvelopeGenerator (void);
 
-	void SetAttack (unsigned nMilliSeconds);
-	void SetDecay (unsigned nMilliSeconds);
-	void SetSustain (float fLevel);			// [0.0, 1.0]
-	void SetRelease (unsigned nMilliSeconds);
+	// pParameters must stay valid, while the envelope generators are used
+	void SetParameters (const TEnvelopeParameters *pParameters);
+
+	void NoteOn (unsigned nVoice, float fVelocityLevel = 1.0);	// (0.0, 1.0]
+	void NoteOff (unsigned nVoice);
+	// falls linearly from the current level to 0.0 within nSamples (>= 1)
+	void Fade (unsigned nVoice, unsigned nSamples);
+	void Stop (unsigned nVoice);				// goes idle at once
+
+	TEnvelopeState GetState (unsigned nVoice) const;
+	unsigned GetRemaining (unsigned nVoice) const;	// samples until the stage ends (0 if none)
 
-	void NoteOn (float fVelocityLevel = 1.0);	// (0.0, 1.0]
-	void NoteOff (void);
+	void RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames);	// at control rate
 
-	TEnvelopeState GetState (void) const;
+	float GetOutputLevel (unsigned nVoice) const;		// returns [0.0, 1.0]
 
-	void NextSample (void);
-	float GetOutputLevel (void) const;		// returns [0.0, 1.0]
+	// the stage lengths are given in milliseconds, fSustainLevel is [0.0, 1.0]
+	static void CompileParameters (unsigned nAttackMs, unsigned nDecayMs, float fSustainLevel,
+				       unsigned nReleaseMs, TEnvelopeCurve Curve,
+				       TEnvelopeParameters *pResult);
 
 private:
-	// returns TRUE if next phase starts
-	boolean CalculateLevel (float fPrevLevel, float fNextLevel, unsigned nMsDelay);
+	// goes from the current level to fEndLevel
+	void StartStage (unsigned nVoice, TEnvelopeState State, float fEndLevel,
+			 const TEnvelopeStage &Stage);
+	void NextStage (unsigned nVoice);
+
+	// advances the level by nSamples, which must not exceed the stage
+	void Advance (unsigned nVoice, unsigned nSamples);
+
+	// renders one piece of one voice, which contains the end of a stage
+	void RenderPiece (unsigned nVoice, float *pBuffer, unsigned nFrames, float fReciprocal);
+
+	static void CompileStage (unsigned nMilliSeconds, float fOvershoot, TEnvelopeStage *pResult);
 
 private:
-	unsigned m_nAttackMsec;
-	unsigned m_nDecayMsec;
-	float    m_fSustainLevel;
-	unsigned m_nReleaseMsec;
+	const TEnvelopeParameters *m_pParameters;
+
+	TEnvelopeState m_State[VOICE_LANES];
+	float m_fVelocityLevel[VOICE_LANES];
 
-	TEnvelopeState m_State;
+	// current stage
+	TEnvelopeCurve m_StageCurve[VOICE_LANES];
+	unsigned m_nRemaining[VOICE_LANES];		// samples until the stage ends
+	float m_fEndLevel[VOICE_LANES];
+	float m_fIncrement[VOICE_LANES];		// per sample (linear)
+	float m_fTarget[VOICE_LANES];		// approached beyond m_fEndLevel (exponential)
+	float m_fMultiplier[VOICE_LANES];		// per sample (exponential)
+	float m_fMultiplierPeriod[VOICE_LANES];	// per control period (exponential)
 
-	float m_fVelocityLevel;				// [0.0, 1.0]
-	unsigned m_nSampleCount;
-	float m_fReleaseLevel;
+	float m_fOutputLevel[VOICE_LANES];		// at the end of the last piece
 
-	float m_fOutputLevel;
+	CControlRate m_ControlRate[VOICE_GROUPS];
 };
 
 #endif
@@ -0,0 +1,104 @@
+//
+// eventqueue.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "eventqueue.h"
+#include <assert.h>
+
+CEventQueue::CEventQueue (void)
+:	m_nWriteIndex (0),
+	m_nReadIndex (0),
+	m_nHighWaterMark (0),
+	m_nOverflowCount (0)
+{
+}
+
+CEventQueue::~CEventQueue (void)
+{
+}
+
+boolean CEventQueue::Enqueue (const TSynthEvent &Event)
+{
+	u32 nWriteIndex = m_nWriteIndex;
+	u32 nReadIndex = __atomic_load_n (&m_nReadIndex, __ATOMIC_ACQUIRE);
+
+	// the indices run freely, their difference is the number of queued events
+	unsigned nCount = nWriteIndex - nReadIndex;
+	assert (nCount <= EVENT_QUEUE_SIZE);
+	if (nCount == EVENT_QUEUE_SIZE)
+	{
+		m_nOverflowCount++;
+
+		return FALSE;
+	}
+
+	m_Event[nWriteIndex & (EVENT_QUEUE_SIZE-1)] = Event;
+
+	// publish the event, after it has been written
+	__atomic_store_n (&m_nWriteIndex, nWriteIndex+1, __ATOMIC_RELEASE);
+
+	if (++nCount > m_nHighWaterMark)
+	{
+		m_nHighWaterMark = nCount;
+	}
+
+	return TRUE;
+}
+
+boolean CEventQueue::Dequeue (TSynthEvent *pEvent)
+{
+	assert (pEvent != 0);
+
+	u32 nReadIndex = m_nReadIndex;
+	if (nReadIndex == __atomic_load_n (&m_nWriteIndex, __ATOMIC_ACQUIRE))
+	{
+		return FALSE;
+	}
+
+	*pEvent = m_Event[nReadIndex & (EVENT_QUEUE_SIZE-1)];
+
+	// free the entry, after it has been read
+	__atomic_store_n (&m_nReadIndex, nReadIndex+1, __ATOMIC_RELEASE);
+
+	return TRUE;
+}
+
+boolean CEventQueue::Peek (TSynthEvent *pEvent) const
+{
+	assert (pEvent != 0);
+
+	u32 nReadIndex = m_nReadIndex;
+	if (nReadIndex == __atomic_load_n (&m_nWriteIndex, __ATOMIC_ACQUIRE))
+	{
+		return FALSE;
+	}
+
+	*pEvent = m_Event[nReadIndex & (EVENT_QUEUE_SIZE-1)];
+
+	return TRUE;
+}
+
+unsigned CEventQueue::GetHighWaterMark (void) const
+{
+	return m_nHighWaterMark;
+}
+
+unsigned CEventQueue::GetOverflowCount (void) const
+{
+	return m_nOverflowCount;
+}
@@ -0,0 +1,81 @@
+//
+// eventqueue.h
+//
+// Lock-free queue, which passes MIDI events to the audio renderer
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _eventqueue_h
+#define _eventqueue_h
+
+#include <circle/types.h>
+#include "config.h"
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE-1)) != 0
+	#error EVENT_QUEUE_SIZE must be a power of 2
+#endif
+
+enum TSynthEventType
+{
+	SynthEventNoteOn,			// key number, velocity
+	SynthEventNoteOff,			// key number
+	SynthEventControlChange,		// TSynthParameter, MIDI value
+	SynthEventProgramChange,		// program number
+	SynthEventUnknown
+};
+
+struct TSynthEvent
+{
+	u32 nTimestamp;				// frame of the sample clock, where it applies
+	u8 Type;				// TSynthEventType
+	u8 ucParam1;
+	u8 ucParam2;
+};
+
+// Ring buffer for one producer and one consumer, which may interrupt each other
+// or run on different cores. Enqueue() must not be called concurrently, a caller
+// with more than one producer has to serialize them.
+
+class CEventQueue
+{
+public:
+	CEventQueue (void);
+	~CEventQueue (void);
+
+	// returns FALSE and drops the event, if the queue is full
+	boolean Enqueue (const TSynthEvent &Event);
+
+	// returns FALSE, if the queue is empty
+	boolean Dequeue (TSynthEvent *pEvent);
+
+	// returns the next event without removing it, FALSE if the queue is empty
+	boolean Peek (TSynthEvent *pEvent) const;
+
+	unsigned GetHighWaterMark (void) const;		// max. number of queued events
+	unsigned GetOverflowCount (void) const;		// number of dropped events
+
+private:
+	TSynthEvent m_Event[EVENT_QUEUE_SIZE];
+
+	u32 m_nWriteIndex;				// written by the producer only
+	u32 m_nReadIndex;				// written by the consumer only
+
+	unsigned m_nHighWaterMark;
+	unsigned m_nOverflowCount;
+};
+
+#endif
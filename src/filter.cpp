@@ -9,7 +9,7 @@
 //		https://github.com/risgk/digital-synth-wra32/blob/master/vcf.js
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,108 +25,172 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "filter.h"
-#include "math.h"
 #include "config.h"
 #include <assert.h>
 
-#define MAX_FREQ	20000
-
-CFilter::CFilter (CSynthModule *pInput, CSynthModule *pModulator, CSynthModule *pEnvelope)
-:	m_pInput (pInput),
-	m_pModulator (pModulator),
-	m_pEnvelope (pEnvelope),
-	m_fCutoffFrequency (80.0),
-	m_fResonance (50.0),
-	m_fModulationVolume (0.0),
-	m_X1 (0.0),
-	m_X2 (0.0),
-	m_Y0 (0.0),
-	m_Y1 (0.0),
-	m_Y2 (0.0)
+CFilterTable CFilter::s_FilterTable;
+
+CFilter::CFilter (void)
+:	m_pParameters (0)
 {
+	// an idle voice has envelope level 0, which results in the minimum cutoff
+	// (the resonance is not known yet, medium resonance is assumed)
+	TFilterCoefficients Coeff;
+	s_FilterTable.GetCoefficients (s_FilterTable.GetRow (50), FILTER_CUTOFF_MIN, &Coeff);
+
+	for (unsigned i = 0; i < VOICE_LANES; i++)
+	{
+		m_fB0_B2[i] = Coeff.B0_B2;
+		m_fB1[i] = Coeff.B1;
+		m_fA1[i] = Coeff.A1;
+		m_fA2[i] = Coeff.A2;
+
+		m_X1[i] = 0.0;
+		m_X2[i] = 0.0;
+		m_Y1[i] = 0.0;
+		m_Y2[i] = 0.0;
+	}
 }
 
 CFilter::~CFilter (void)
 {
-	m_pInput = 0;
-	m_pModulator = 0;
-	m_pEnvelope = 0;
+	m_pParameters = 0;
 }
 
-void CFilter::SetCutoffFrequency (unsigned nPercent)
+void CFilter::SetParameters (const TFilterParameters *pParameters)
 {
-	assert (nPercent <= 100);
-	m_fCutoffFrequency = (float) nPercent;
+	assert (pParameters != 0);
+	assert (pParameters->pCoefficients != 0);
+	m_pParameters = pParameters;
 }
 
-void CFilter::SetResonance (unsigned nPercent)
+void CFilter::CompileParameters (unsigned nCutoffFrequency, unsigned nResonance,
+				 float fModulationVolume, TFilterParameters *pResult)
 {
-	assert (nPercent <= 100);
-	m_fResonance = (float) nPercent;
-
-	// optimizing for speed because "a" is fixed: pow(a, b) == exp(log(a)*b)
-	// m_Q = powf (sqrt (2), (m_fResonance - 100.0/5.0) / (100.0/5.0));
-#define LOG_SQRT2	0.34657359f
-	m_Q = expf (LOG_SQRT2 * (m_fResonance - 100.0/5.0) / (100.0/5.0));
+	assert (nCutoffFrequency <= 100);
+	assert (nResonance <= 100);
+	assert (0.0 <= fModulationVolume && fModulationVolume <= 1.0);
+	assert (pResult != 0);
+
+	pResult->fCutoffFrequency = (float) nCutoffFrequency;
+	pResult->pCoefficients = s_FilterTable.GetRow (nResonance);
+	pResult->fModulationVolume = fModulationVolume;
 }
 
-void CFilter::SetModulationVolume (float fVolume)
+void CFilter::UpdateTable (void)
 {
-	assert (0.0 <= fVolume && fVolume <= 1.0);
-	m_fModulationVolume = fVolume;
+	s_FilterTable.Build ();
 }
 
-void CFilter::NextSample (void)
+void CFilter::RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames, const float *pInput,
+			   const float *pModulation, const float *pEnvelope)
 {
-	float fCutoffFrequency = m_fCutoffFrequency;
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+	assert (pInput != 0);
+	assert (pModulation != 0);
+	assert (pEnvelope != 0);
 
-	assert (m_pModulator != 0);
-	fCutoffFrequency *= 1.0 + m_pModulator->GetOutputLevel ()*m_fModulationVolume;
+	const TFilterParameters *pParameters = m_pParameters;
+	assert (pParameters != 0);
 
-	assert (m_pEnvelope != 0);
-	fCutoffFrequency *= m_pEnvelope->GetOutputLevel ();
+	const TFilterCoefficients *pRow = pParameters->pCoefficients;
+	assert (pRow != 0);
 
-	if (fCutoffFrequency < 10)
-	{
-		fCutoffFrequency = 10;
-	}
-	else if (fCutoffFrequency > 100)
-	{
-		fCutoffFrequency = 100;
-	}
+	float fModulationVolume = pParameters->fModulationVolume;
 
-	CalculateCoefficients (fCutoffFrequency);
+	unsigned nFirst = nGroup * VECTOR_LANES;
+	CControlRate ControlRate = m_ControlRate[nGroup];
 
-	assert (m_pInput != 0);
-	float X0 = m_pInput->GetOutputLevel ();
+	TVector B0_B2 = VectorLoad (&m_fB0_B2[nFirst]);
+	TVector B1 = VectorLoad (&m_fB1[nFirst]);
+	TVector A1 = VectorLoad (&m_fA1[nFirst]);
+	TVector A2 = VectorLoad (&m_fA2[nFirst]);
 
-	m_Y0 = (m_B0_B2*X0 + m_B1*m_X1 + m_B0_B2*m_X2 - m_A1*m_Y1 - m_A2*m_Y2) / m_A0;
+	TVector X1 = VectorLoad (&m_X1[nFirst]);
+	TVector X2 = VectorLoad (&m_X2[nFirst]);
+	TVector Y1 = VectorLoad (&m_Y1[nFirst]);
+	TVector Y2 = VectorLoad (&m_Y2[nFirst]);
 
-	m_X2 = m_X1;
-	m_Y2 = m_Y1;
-	m_X1 = X0;
-	m_Y1 = m_Y0;
-}
+	for (unsigned i = 0; i < nFrames;)
+	{
+		float fReciprocal;
+		unsigned nPiece = ControlRate.NextPiece (nFrames - i, &fReciprocal);
+
+		// the cutoff frequency is calculated at the end of the piece only
+		float TargetB0_B2[VECTOR_LANES];
+		float TargetB1[VECTOR_LANES];
+		float TargetA1[VECTOR_LANES];
+		float TargetA2[VECTOR_LANES];
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
+		{
+			unsigned nEnd = (i + nPiece-1) * VECTOR_LANES + l;
+			float fCutoffFrequency = pParameters->fCutoffFrequency;
+			fCutoffFrequency *= 1.0f + pModulation[nEnd]*fModulationVolume;
+			fCutoffFrequency *= pEnvelope[nEnd];
+
+			if (fCutoffFrequency < FILTER_CUTOFF_MIN)
+			{
+				fCutoffFrequency = FILTER_CUTOFF_MIN;
+			}
+			else if (fCutoffFrequency > FILTER_CUTOFF_MAX)
+			{
+				fCutoffFrequency = FILTER_CUTOFF_MAX;
+			}
+
+			TFilterCoefficients Target;
+			s_FilterTable.GetCoefficients (pRow, fCutoffFrequency, &Target);
+
+			TargetB0_B2[l] = Target.B0_B2;
+			TargetB1[l] = Target.B1;
+			TargetA1[l] = Target.A1;
+			TargetA2[l] = Target.A2;
+		}
+
+		// interpolate the coefficients up to the new values
+		TVector Reciprocal = VectorSet (fReciprocal);
+		TVector StepB0_B2 = VectorMul (VectorSub (VectorLoad (TargetB0_B2), B0_B2), Reciprocal);
+		TVector StepB1 = VectorMul (VectorSub (VectorLoad (TargetB1), B1), Reciprocal);
+		TVector StepA1 = VectorMul (VectorSub (VectorLoad (TargetA1), A1), Reciprocal);
+		TVector StepA2 = VectorMul (VectorSub (VectorLoad (TargetA2), A2), Reciprocal);
+
+		for (unsigned j = 0; j < nPiece; j++)
+		{
+			B0_B2 = VectorAdd (B0_B2, StepB0_B2);
+			B1 = VectorAdd (B1, StepB1);
+			A1 = VectorAdd (A1, StepA1);
+			A2 = VectorAdd (A2, StepA2);
+
+			// Y0 = B0_B2*(X0 + X2) + B1*X1 - A1*Y1 - A2*Y2
+			TVector X0 = VectorLoad (&pInput[i * VECTOR_LANES]);
+			TVector Y0 = VectorSub (VectorSub (VectorAdd (VectorMul (B0_B2, VectorAdd (X0, X2)),
+								      VectorMul (B1, X1)),
+							   VectorMul (A1, Y1)),
+						VectorMul (A2, Y2));
+
+			X2 = X1;
+			Y2 = Y1;
+			X1 = X0;
+			Y1 = Y0;
+
+			VectorStore (&pBuffer[i++ * VECTOR_LANES], Y0);
+		}
+
+		// avoid accumulating rounding errors
+		B0_B2 = VectorLoad (TargetB0_B2);
+		B1 = VectorLoad (TargetB1);
+		A1 = VectorLoad (TargetA1);
+		A2 = VectorLoad (TargetA2);
+	}
 
-float CFilter::GetOutputLevel (void) const
-{
-	return m_Y0;
-}
+	VectorStore (&m_fB0_B2[nFirst], B0_B2);
+	VectorStore (&m_fB1[nFirst], B1);
+	VectorStore (&m_fA1[nFirst], A1);
+	VectorStore (&m_fA2[nFirst], A2);
+	m_ControlRate[nGroup] = ControlRate;
 
-void CFilter::CalculateCoefficients (float fCutoffFrequency)
-{
-	// optimizing for speed because "a" is fixed: pow(a, b) == exp(log(a)*b)
-	// float F0 = powf (2.0, (m_fCutoffFrequency-100.0) / 10.0) * MAX_FREQ;
-#define LOG_2	0.69314718f
-	float F0 = expf (LOG_2 * (fCutoffFrequency-100.0) / 10.0) * MAX_FREQ;
-
-	float W0 = 2.0*PI * F0 / SAMPLE_RATE;
-	float Alpha = sinf (W0) / (2.0*m_Q);
-	float CosW0 = cosf (W0);
-
-	m_A0 =  1.0 + Alpha;
-	m_A1 = -2.0 * CosW0;
-	m_A2 =  1.0 - Alpha;
-	m_B1 =  1.0 - CosW0;
-	m_B0_B2 = m_B1 / 2.0;		// coefficients B0 and B2 are equal
+	VectorStore (&m_X1[nFirst], X1);
+	VectorStore (&m_X2[nFirst], X2);
+	VectorStore (&m_Y1[nFirst], Y1);
+	VectorStore (&m_Y2[nFirst], Y2);
 }
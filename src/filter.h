@@ -4,7 +4,7 @@
 // Low-pass filter
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,46 +22,58 @@
 #ifndef _filter_h
 #define _filter_h
 
-#include "synthmodule.h"
+#include "filtertable.h"
+#include "controlrate.h"
+#include "simd.h"
+#include "config.h"
 
-class CFilter : public CSynthModule
+struct TFilterParameters
+{
+	float fCutoffFrequency;				// in percent
+	const TFilterCoefficients *pCoefficients;	// table row for the resonance
+	float fModulationVolume;
+};
+
+// Holds the filters of the VOICES_PER_CORE voices of a voice bank (nVoice is the
+// index in the bank) in arrays over the voices for each field. They are rendered
+// in groups of VECTOR_LANES voices (nGroup, see COscillator).
+
+class CFilter
 {
 public:
-	CFilter (CSynthModule *pInput, CSynthModule *pModulator, CSynthModule *pEnvelope);
+	CFilter (void);
 	~CFilter (void);
 
-	void SetCutoffFrequency (unsigned nPercent);
-	void SetResonance (unsigned nPercent);
-	void SetModulationVolume (float fVolume);	// [0.0, 1.0]
+	// pParameters must stay valid, while the filters are rendered
+	void SetParameters (const TFilterParameters *pParameters);
 
-	void NextSample (void);
-	float GetOutputLevel (void) const;		// returns [-1.0, 1.0]
+	// pInput, pModulation and pEnvelope are the output blocks of the input modules
+	void RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames, const float *pInput,
+			  const float *pModulation, const float *pEnvelope);
 
-private:
-	void CalculateCoefficients (float fCutoffFrequency);
+	// cutoff frequency and resonance in percent, fModulationVolume is [0.0, 1.0]
+	static void CompileParameters (unsigned nCutoffFrequency, unsigned nResonance,
+				       float fModulationVolume, TFilterParameters *pResult);
+
+	static void UpdateTable (void);			// after the sample rate has changed
 
 private:
-	CSynthModule *m_pInput;
-	CSynthModule *m_pModulator;
-	CSynthModule *m_pEnvelope;
+	const TFilterParameters *m_pParameters;
 
-	float m_fCutoffFrequency;
-	float m_fResonance;
-	float m_fModulationVolume;
+	CControlRate m_ControlRate[VOICE_GROUPS];	// for the cutoff frequency
 
-	float m_Q;
+	// coefficients at the end of the last piece
+	float m_fB0_B2[VOICE_LANES];
+	float m_fB1[VOICE_LANES];
+	float m_fA1[VOICE_LANES];
+	float m_fA2[VOICE_LANES];
 
-	float m_A0;
-	float m_A1;
-	float m_A2;
-	float m_B0_B2;
-	float m_B1;
+	float m_X1[VOICE_LANES];
+	float m_X2[VOICE_LANES];
+	float m_Y1[VOICE_LANES];
+	float m_Y2[VOICE_LANES];
 
-	float m_X1;
-	float m_X2;
-	float m_Y0;
-	float m_Y1;
-	float m_Y2;
+	static CFilterTable s_FilterTable;
 };
 
 #endif
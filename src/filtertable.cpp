@@ -0,0 +1,98 @@
+//
+// filtertable.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "filtertable.h"
+#include "samplerate.h"
+#include "math.h"
+#include <assert.h>
+
+#define MAX_FREQ	20000
+#define MAX_NYQUIST	0.45f		// fraction of the sample rate, where MAX_FREQ is limited
+
+CFilterTable::CFilterTable (void)
+{
+	Build ();
+}
+
+CFilterTable::~CFilterTable (void)
+{
+}
+
+void CFilterTable::Build (void)
+{
+	// the cutoff (in percent), which is limited to MAX_NYQUIST (see below)
+	float fCutoffMax = 100.0f + 10.0f * log2f (MAX_NYQUIST * CSampleRate::Get () / MAX_FREQ);
+	if (fCutoffMax > FILTER_CUTOFF_MAX)
+	{
+		fCutoffMax = FILTER_CUTOFF_MAX;
+	}
+
+	m_fIndexFactor = FILTER_TABLE_SIZE / (fCutoffMax - FILTER_CUTOFF_MIN);
+
+	for (unsigned nResonance = 0; nResonance < FILTER_RESONANCE_STEPS; nResonance++)
+	{
+		for (unsigned i = 0; i <= FILTER_TABLE_SIZE; i++)
+		{
+			float fCutoffFrequency =   FILTER_CUTOFF_MIN
+						 + i * (fCutoffMax - FILTER_CUTOFF_MIN)
+						     / FILTER_TABLE_SIZE;
+
+			CalculateCoefficients (fCutoffFrequency, nResonance, &m_Table[nResonance][i]);
+		}
+	}
+}
+
+const TFilterCoefficients *CFilterTable::GetRow (unsigned nResonance) const
+{
+	assert (nResonance < FILTER_RESONANCE_STEPS);
+	return m_Table[nResonance];
+}
+
+void CFilterTable::CalculateCoefficients (float fCutoffFrequency, unsigned nResonance,
+					  TFilterCoefficients *pResult)
+{
+	assert (nResonance < FILTER_RESONANCE_STEPS);
+	assert (pResult != 0);
+
+	// Q = sqrt(2) ^ ((resonance - 20) / 20)
+#define LOG_SQRT2	0.34657359f
+	float Q = expf (LOG_SQRT2 * (nResonance - 100.0f/5.0f) / (100.0f/5.0f));
+
+	// F0 = 2 ^ ((cutoff - 100) / 10) * MAX_FREQ
+#define LOG_2		0.69314718f
+	float F0 = expf (LOG_2 * (fCutoffFrequency-100.0f) / 10.0f) * MAX_FREQ;
+
+	float fSampleRate = (float) CSampleRate::Get ();
+	if (F0 > MAX_NYQUIST * fSampleRate)
+	{
+		F0 = MAX_NYQUIST * fSampleRate;
+	}
+
+	float W0 = 2.0f*PI * F0 / fSampleRate;
+	float Alpha = sinf (W0) / (2.0f*Q);
+	float CosW0 = cosf (W0);
+
+	float A0 = 1.0f + Alpha;
+	float B1 = 1.0f - CosW0;
+
+	pResult->B0_B2 = B1 / 2.0f / A0;
+	pResult->B1    = B1 / A0;
+	pResult->A1    = -2.0f * CosW0 / A0;
+	pResult->A2    = (1.0f - Alpha) / A0;
+}
@@ -0,0 +1,94 @@
+//
+// filtertable.h
+//
+// Pre-calculated low-pass filter coefficients for CFilter
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _filtertable_h
+#define _filtertable_h
+
+#include "config.h"
+
+#define FILTER_CUTOFF_MIN	10.0f		// percent
+#define FILTER_CUTOFF_MAX	100.0f
+#define FILTER_RESONANCE_STEPS	101		// 0..100 percent
+
+struct TFilterCoefficients			// normalized by A0
+{
+	float B0_B2;				// coefficients B0 and B2 are equal
+	float B1;
+	float A1;
+	float A2;
+};
+
+// There is one row of FILTER_TABLE_SIZE+1 coefficient sets for each resonance
+// value, spaced evenly over the cutoff range (in percent, which is logarithmic
+// in Hz). The coefficients in between are linearly interpolated. At a low sample
+// rate the range ends, where the cutoff is limited below the Nyquist frequency,
+// so that the limit is not interpolated.
+
+class CFilterTable
+{
+public:
+	CFilterTable (void);				// builds the table
+	~CFilterTable (void);
+
+	void Build (void);				// for the current sample rate
+
+	const TFilterCoefficients *GetRow (unsigned nResonance) const;
+
+	// fCutoffFrequency must be clamped to [FILTER_CUTOFF_MIN, FILTER_CUTOFF_MAX]
+	void GetCoefficients (const TFilterCoefficients *pRow, float fCutoffFrequency,
+			      TFilterCoefficients *pResult) const;
+
+	// the exact coefficients for any cutoff frequency (in percent),
+	// which is limited below the Nyquist frequency
+	static void CalculateCoefficients (float fCutoffFrequency, unsigned nResonance,
+					   TFilterCoefficients *pResult);
+
+private:
+	float m_fIndexFactor;				// table steps per percent of cutoff
+
+	TFilterCoefficients m_Table[FILTER_RESONANCE_STEPS][FILTER_TABLE_SIZE+1];
+};
+
+inline void CFilterTable::GetCoefficients (const TFilterCoefficients *pRow, float fCutoffFrequency,
+					   TFilterCoefficients *pResult) const
+{
+	float fIndex = (fCutoffFrequency - FILTER_CUTOFF_MIN) * m_fIndexFactor;
+	if (fIndex > FILTER_TABLE_SIZE)			// above the Nyquist limit
+	{
+		fIndex = FILTER_TABLE_SIZE;
+	}
+
+	unsigned nIndex = (unsigned) fIndex;
+	if (nIndex >= FILTER_TABLE_SIZE)
+	{
+		nIndex = FILTER_TABLE_SIZE-1;
+	}
+
+	float fFraction = fIndex - nIndex;
+
+	const TFilterCoefficients *p = &pRow[nIndex];
+	pResult->B0_B2 = p[0].B0_B2 + fFraction * (p[1].B0_B2 - p[0].B0_B2);
+	pResult->B1    = p[0].B1    + fFraction * (p[1].B1    - p[0].B1);
+	pResult->A1    = p[0].A1    + fFraction * (p[1].A1    - p[0].A1);
+	pResult->A2    = p[0].A2    + fFraction * (p[1].A2    - p[0].A2);
+}
+
+#endif
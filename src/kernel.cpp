@@ -2,7 +2,7 @@
 // kernel.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2025  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -19,6 +19,7 @@
 //
 #include "kernel.h"
 #include "mainwindow.h"
+#include "samplerate.h"
 #include "config.h"
 #include <circle/machineinfo.h>
 #include <circle/string.h>
@@ -111,28 +112,91 @@ boolean CKernel::Initialize (void)
 
 	if (bOK)
 	{
+		// before the engine is constructed
+		unsigned nSampleRate = m_Options.GetAppOptionDecimal ("samplerate",
+								      SAMPLE_RATE_DEFAULT);
+		if (!CSampleRate::Set (nSampleRate))
+		{
+			m_Logger.Write (FromKernel, LogWarning, "Invalid option samplerate=%u",
+					nSampleRate);
+		}
+
+		unsigned nChunkFrames = m_Options.GetAppOptionDecimal ("chunksize", CHUNK_FRAMES);
+		if (   nChunkFrames < MIN_CHUNK_FRAMES
+		    || nChunkFrames > MAX_FRAMES_PER_CHUNK)
+		{
+			m_Logger.Write (FromKernel, LogWarning, "Invalid option chunksize=%u",
+					nChunkFrames);
+
+			nChunkFrames = CHUNK_FRAMES;
+		}
+
 		const char *pSoundDevice = m_Options.GetSoundDevice ();
 		assert (pSoundDevice);
 		if (strcmp (pSoundDevice, "sndi2s") == 0)
 		{
 			m_pSynthesizer = new CMiniSynthesizerI2S (&m_Config, &m_Interrupt,
-								  &m_I2CMaster);
+								  &m_I2CMaster, nChunkFrames);
 		}
 #if RASPPI >= 4
 		else if (strcmp (pSoundDevice, "sndusb") == 0)
 		{
+			// the chunks follow the USB frames
+			if (m_Options.GetAppOptionString ("chunksize") != 0)
+			{
+				m_Logger.Write (FromKernel, LogWarning,
+						"Option chunksize= is ignored with sndusb");
+			}
+
 			m_pSynthesizer = new CMiniSynthesizerUSB (&m_Config, &m_Interrupt);
 		}
 #endif
 		else
 		{
-			m_pSynthesizer = new CMiniSynthesizerPWM (&m_Config, &m_Interrupt);
+			m_pSynthesizer = new CMiniSynthesizerPWM (&m_Config, &m_Interrupt,
+								  nChunkFrames);
 		}
 
 		assert (m_pSynthesizer);
 		bOK = m_pSynthesizer->Initialize ();
 	}
 
+	if (bOK)
+	{
+		const char *pVoiceSteal = m_Options.GetAppOptionString ("voicesteal");
+		TVoiceStealing Policy = CVoiceManager::GetVoiceStealing (pVoiceSteal);
+		if (Policy >= VoiceStealingUnknown)
+		{
+			m_Logger.Write (FromKernel, LogWarning, "Invalid option voicesteal=%s",
+					pVoiceSteal);
+
+			Policy = CVoiceManager::GetVoiceStealing (0);
+		}
+
+		m_pSynthesizer->SetVoiceStealing (Policy,
+			m_Options.GetAppOptionDecimal ("retrigger", 1) != 0);
+
+		m_pSynthesizer->SetCullLevel (m_Options.GetAppOptionDecimal ("voicecull",
+									    VOICE_CULL_DB));
+
+		unsigned nRenderAhead = m_Options.GetAppOptionDecimal ("renderahead",
+								       RENDER_AHEAD_CHUNKS);
+		m_pSynthesizer->SetRenderAhead (nRenderAhead);
+
+		// in GetChunk() the reverb would run in series with the voices anyway
+		boolean bEffectsCore = m_Options.GetAppOptionDecimal ("effectscore", 0) != 0;
+		if (   bEffectsCore
+		    && nRenderAhead == 0)
+		{
+			m_Logger.Write (FromKernel, LogWarning,
+					"Option effectscore=1 requires renderahead=1 or more");
+
+			bEffectsCore = FALSE;
+		}
+
+		m_pSynthesizer->SetEffectsCore (bEffectsCore);
+	}
+
 	return bOK;
 }
 
@@ -185,6 +249,12 @@ TShutdownMode CKernel::Run (void)
 			MainWindow.UpdateAllParameters (TRUE);
 		}
 
+		u32 nParameters = m_pSynthesizer->ParametersUpdated ();
+		if (nParameters != 0)
+		{
+			MainWindow.UpdateParameters (nParameters);
+		}
+
 		m_GUI.Update (bUpdated);
 
 		m_CPUThrottle.Update ();
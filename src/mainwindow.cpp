@@ -2,7 +2,7 @@
 // mainwindow.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2024  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -48,6 +48,7 @@ CMainWindow::CMainWindow (CMiniSynthesizer *pSynthesizer, CSynthConfig *pConfig)
 	m_EGVCFDecay (m_pTabMain, EGVCFDecay, pConfig),
 	m_EGVCFSustain (m_pTabMain, EGVCFSustain, pConfig),
 	m_EGVCFRelease (m_pTabMain, EGVCFRelease, pConfig),
+	m_EGVCFCurve (m_pTabMain, EGVCFCurve, pConfig),
 	m_VCFModulationVolume (m_pTabMain, VCFModulationVolume, pConfig),
 	m_LFOVCAWaveform (m_pTabMain, LFOVCAWaveform, pConfig),
 	m_LFOVCAFrequency (m_pTabMain, LFOVCAFrequency, pConfig),
@@ -55,6 +56,7 @@ CMainWindow::CMainWindow (CMiniSynthesizer *pSynthesizer, CSynthConfig *pConfig)
 	m_EGVCADecay (m_pTabMain, EGVCADecay, pConfig),
 	m_EGVCASustain (m_pTabMain, EGVCASustain, pConfig),
 	m_EGVCARelease (m_pTabMain, EGVCARelease, pConfig),
+	m_EGVCACurve (m_pTabMain, EGVCACurve, pConfig),
 	m_VCAModulationVolume (m_pTabMain, VCAModulationVolume, pConfig),
 	m_SynthVolume (m_pTabMain, SynthVolume, pConfig),
 	m_ReverbDecay (m_pTabMain, ReverbDecay, pConfig),
@@ -68,6 +70,34 @@ CMainWindow::CMainWindow (CMiniSynthesizer *pSynthesizer, CSynthConfig *pConfig)
 	assert (s_pThis == 0);
 	s_pThis = this;
 
+	m_pParameter[LFOVCOWaveform] = &m_LFOVCOWaveform;
+	m_pParameter[LFOVCOFrequency] = &m_LFOVCOFrequency;
+	m_pParameter[VCOWaveform] = &m_VCOWaveform;
+	m_pParameter[VCOModulationVolume] = &m_VCOModulationVolume;
+	m_pParameter[VCODetune] = &m_VCODetune;
+	m_pParameter[LFOVCFWaveform] = &m_LFOVCFWaveform;
+	m_pParameter[LFOVCFFrequency] = &m_LFOVCFFrequency;
+	m_pParameter[VCFCutoffFrequency] = &m_VCFCutoffFrequency;
+	m_pParameter[VCFResonance] = &m_VCFResonance;
+	m_pParameter[EGVCFAttack] = &m_EGVCFAttack;
+	m_pParameter[EGVCFDecay] = &m_EGVCFDecay;
+	m_pParameter[EGVCFSustain] = &m_EGVCFSustain;
+	m_pParameter[EGVCFRelease] = &m_EGVCFRelease;
+	m_pParameter[EGVCFCurve] = &m_EGVCFCurve;
+	m_pParameter[VCFModulationVolume] = &m_VCFModulationVolume;
+	m_pParameter[LFOVCAWaveform] = &m_LFOVCAWaveform;
+	m_pParameter[LFOVCAFrequency] = &m_LFOVCAFrequency;
+	m_pParameter[EGVCAAttack] = &m_EGVCAAttack;
+	m_pParameter[EGVCADecay] = &m_EGVCADecay;
+	m_pParameter[EGVCASustain] = &m_EGVCASustain;
+	m_pParameter[EGVCARelease] = &m_EGVCARelease;
+	m_pParameter[EGVCACurve] = &m_EGVCACurve;
+	m_pParameter[VCAModulationVolume] = &m_VCAModulationVolume;
+	m_pParameter[ReverbDecay] = &m_ReverbDecay;
+	m_pParameter[ReverbVolume] = &m_ReverbVolume;
+	m_pParameter[SynthVolume] = &m_SynthVolume;
+	m_pParameter[MIDIChannel] = &m_MIDIChannel;
+
 	// setup styles
 	lv_style_init (&m_StyleNoBorder);
 	lv_style_set_radius (&m_StyleNoBorder, 0);
@@ -119,6 +149,7 @@ CMainWindow::CMainWindow (CMiniSynthesizer *pSynthesizer, CSynthConfig *pConfig)
 	m_EGVCFDecay.Create (210, 300);
 	m_EGVCFSustain.Create (210, 330);
 	m_EGVCFRelease.Create (210, 360);
+	m_EGVCFCurve.Create (210, 390);
 	// amplifier
 	LabelCreate (m_pTabMain, 405, 5, "AMPLIFIER", LabelStyleSection);
 	LabelCreate (m_pTabMain, 405, 30, "MASTER VOLUME");
@@ -132,6 +163,7 @@ CMainWindow::CMainWindow (CMiniSynthesizer *pSynthesizer, CSynthConfig *pConfig)
 	m_EGVCADecay.Create (410, 300);
 	m_EGVCASustain.Create (410, 330);
 	m_EGVCARelease.Create (410, 360);
+	m_EGVCACurve.Create (410, 390);
 	// effects
 	LabelCreate (m_pTabMain, 605, 5, "EFFECTS", LabelStyleSection);
 	LabelCreate (m_pTabMain, 605, 30, "REVERB");
@@ -213,6 +245,7 @@ void CMainWindow::EventHandler (lv_obj_t *pObject, lv_event_code_t Event)
 		    || m_EGVCFDecay.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_EGVCFSustain.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_EGVCFRelease.EventHandler (pObject, Event, m_bShowHelp)
+		    || m_EGVCFCurve.EventHandler (pObject, Event, m_bShowHelp)
 		       // amplifier
 		    || m_SynthVolume.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_LFOVCAWaveform.EventHandler (pObject, Event, m_bShowHelp)
@@ -222,6 +255,7 @@ void CMainWindow::EventHandler (lv_obj_t *pObject, lv_event_code_t Event)
 		    || m_EGVCADecay.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_EGVCASustain.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_EGVCARelease.EventHandler (pObject, Event, m_bShowHelp)
+		    || m_EGVCACurve.EventHandler (pObject, Event, m_bShowHelp)
 		       // reverb
 		    || m_ReverbDecay.EventHandler (pObject, Event, m_bShowHelp)
 		    || m_ReverbVolume.EventHandler (pObject, Event, m_bShowHelp))
@@ -317,6 +351,7 @@ void CMainWindow::UpdateAllParameters (boolean bUpdatePatch)
 	m_EGVCFDecay.Update (m_bShowHelp);
 	m_EGVCFSustain.Update (m_bShowHelp);
 	m_EGVCFRelease.Update (m_bShowHelp);
+	m_EGVCFCurve.Update (m_bShowHelp);
 
 	// amplifier
 	m_SynthVolume.Update (m_bShowHelp);
@@ -327,6 +362,7 @@ void CMainWindow::UpdateAllParameters (boolean bUpdatePatch)
 	m_EGVCADecay.Update (m_bShowHelp);
 	m_EGVCASustain.Update (m_bShowHelp);
 	m_EGVCARelease.Update (m_bShowHelp);
+	m_EGVCACurve.Update (m_bShowHelp);
 
 	// reverb
 	m_ReverbDecay.Update (m_bShowHelp);
@@ -370,6 +406,18 @@ void CMainWindow::UpdateAllParameters (boolean bUpdatePatch)
 	}
 }
 
+void CMainWindow::UpdateParameters (u32 nParameterMask)
+{
+	for (unsigned i = 0; i < SynthParameterUnknown; i++)
+	{
+		if (nParameterMask & (1U << i))
+		{
+			assert (m_pParameter[i] != 0);
+			m_pParameter[i]->Update (m_bShowHelp);
+		}
+	}
+}
+
 void CMainWindow::UpdateSynthPatch (void)
 {
 	assert (m_pSynthesizer != 0);
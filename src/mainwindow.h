@@ -2,7 +2,7 @@
 // mainwindow.h
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2024  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -36,6 +36,7 @@ public:
 	void SetHeight (unsigned nPercent);
 
 	void UpdateAllParameters (boolean bUpdatePatch = FALSE);
+	void UpdateParameters (u32 nParameterMask);	// bit 1 << TSynthParameter
 
 	void UpdateSynthPatch (void);
 
@@ -98,6 +99,7 @@ private:
 	CGUIParameter m_EGVCFDecay;
 	CGUIParameter m_EGVCFSustain;
 	CGUIParameter m_EGVCFRelease;
+	CGUIParameter m_EGVCFCurve;
 	CGUIParameter m_VCFModulationVolume;
 	CGUIParameter m_LFOVCAWaveform;
 	CGUIParameter m_LFOVCAFrequency;
@@ -105,12 +107,15 @@ private:
 	CGUIParameter m_EGVCADecay;
 	CGUIParameter m_EGVCASustain;
 	CGUIParameter m_EGVCARelease;
+	CGUIParameter m_EGVCACurve;
 	CGUIParameter m_VCAModulationVolume;
 	CGUIParameter m_SynthVolume;
 	CGUIParameter m_ReverbDecay;
 	CGUIParameter m_ReverbVolume;
 	CGUIParameter m_MIDIChannel;
 
+	CGUIParameter *m_pParameter[SynthParameterUnknown];
+
 	CGUIStringProperty m_PropertyName;
 	CGUIStringProperty m_PropertyAuthor;
 	CGUIStringProperty m_PropertyComment;
@@ -2,7 +2,7 @@
 // minisynth.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2024  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -18,16 +18,22 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "minisynth.h"
+#include "samplerate.h"
 #include "math.h"
 #include "config.h"
 #include <circle/timer.h>
 #include <circle/synchronize.h>
 #include <circle/memory.h>
+#include <circle/new.h>
 #include <circle/logger.h>
 #include <assert.h>
 
+#define USB_CHUNK_WAIT_MS	1000			// for the first GetChunk() of a USB device
+
 static const char FromMiniSynth[] = "synth";
 
+static const float Silence[MAX_FRAMES_PER_CHUNK] = {0};	// output on underrun
+
 CMiniSynthesizer::CMiniSynthesizer (CSynthConfig *pConfig, CInterruptSystem *pInterrupt)
 :	m_pConfig (pConfig),
 	m_MIDIKeyboard0 (this, pConfig, 0),
@@ -37,8 +43,23 @@ CMiniSynthesizer::CMiniSynthesizer (CSynthConfig *pConfig, CInterruptSystem *pIn
 	m_bUseSerial (FALSE),
 	m_nConfigRevisionWrite (0),
 	m_nConfigRevisionRead (0),
+	m_pPendingPatch (0),
+	m_pActivePatch (0),
+	m_nProgramChanges (0),
+	m_nChangedParameters (0),
+	m_nUpdatedParameters (0),
+	m_nSampleClock (0),
+	m_nPlayClock (0),
+	m_nChunkClock (0),
+	m_nChunkFrames (0),
+	m_nChunkTicks (0),
+	m_nRenderAheadChunks (0),
+	m_nRenderAheadFrames (0),
+	m_bUnderrun (FALSE),
+	m_nUnderrunCount (0),
+	m_bEffectsCore (FALSE),
 	m_VoiceManager (CMemorySystem::Get ()),
-	m_fVolume (0.0)
+	m_SpinLock (IRQ_LEVEL)
 #ifdef SHOW_STATUS
 	, m_nMaxDelayTicks (0)
 #endif
@@ -47,6 +68,12 @@ CMiniSynthesizer::CMiniSynthesizer (CSynthConfig *pConfig, CInterruptSystem *pIn
 
 CMiniSynthesizer::~CMiniSynthesizer (void)
 {
+#ifdef ARM_ALLOW_MULTI_CORE
+	if (m_nRenderAheadChunks > 0)
+	{
+		m_VoiceManager.StopRenderAhead ();
+	}
+#endif
 }
 
 boolean CMiniSynthesizer::Initialize (void)
@@ -57,12 +84,70 @@ boolean CMiniSynthesizer::Initialize (void)
 
 		m_bUseSerial = TRUE;
 
-		return m_VoiceManager.Initialize ();
+		if (!m_VoiceManager.Initialize ())
+		{
+			return FALSE;
+		}
+
+#ifdef ARM_ALLOW_MULTI_CORE
+		// the secondary cores sleep, while they wait for a job
+		const unsigned Pings = 1000;
+		unsigned nStartTicks = CTimer::GetClockTicks ();
+		for (unsigned i = 0; i < Pings; i++)
+		{
+			m_VoiceManager.PingCores ();
+		}
+		unsigned nTicks = CTimer::GetClockTicks () - nStartTicks;
+
+		CLogger::Get ()->Write (FromMiniSynth, LogNotice,
+					"Waking up the cores takes %u ns (block %u us)",
+					(unsigned) ((u64) nTicks * 1000000000 / CLOCKHZ / Pings),
+					FRAMES_PER_BLOCK * 1000000U / CSampleRate::Get ());
+#endif
+
+		return TRUE;
 	}
 
 	return FALSE;
 }
 
+void CMiniSynthesizer::SetRenderAhead (unsigned nChunks)
+{
+	assert (m_nRenderAheadChunks == 0);
+
+	if (nChunks == 0)
+	{
+		return;
+	}
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	m_nRenderAheadChunks = nChunks;
+
+	m_VoiceManager.StartRenderAhead (RenderAheadHandler, this);
+
+	CLogger::Get ()->Write (FromMiniSynth, LogNotice, "Rendering %u chunks ahead on core %u",
+				nChunks, RENDER_CORE);
+#else
+	CLogger::Get ()->Write (FromMiniSynth, LogWarning, "Rendering ahead requires multi-core");
+#endif
+}
+
+void CMiniSynthesizer::SetEffectsCore (boolean bOn)
+{
+#ifdef ARM_ALLOW_MULTI_CORE
+	// GetChunk() would have to wait for EFFECTS_CORE otherwise
+	assert (!bOn || m_nRenderAheadChunks > 0);
+
+	// the renderer switches before its next part
+	__atomic_store_n (&m_bEffectsCore, bOn, __ATOMIC_RELAXED);
+#else
+	if (bOn)
+	{
+		CLogger::Get ()->Write (FromMiniSynth, LogWarning, "Effects core requires multi-core");
+	}
+#endif
+}
+
 void CMiniSynthesizer::Process (boolean bPlugAndPlayUpdated)
 {
 	m_MIDIKeyboard0.Process (bPlugAndPlayUpdated);
@@ -82,35 +167,45 @@ void CMiniSynthesizer::SetPatch (CPatch *pPatch)
 
 	GlobalLock ();
 
-	m_VoiceManager.SetPatch (pPatch);
-
-	m_fVolume = powf (pPatch->GetParameter (SynthVolume) / 100.0, 3.3f); // apply some curve
+	m_PatchCompiler.Publish (pPatch);
+	m_pPendingPatch = pPatch;
+	m_nChangedParameters = 0;
 
 	GlobalUnlock ();
 }
 
-void CMiniSynthesizer::NoteOn (u8 ucKeyNumber, u8 ucVelocity)
+void CMiniSynthesizer::SetVoiceStealing (TVoiceStealing Policy, boolean bRetrigger)
 {
-	// apply velocity curve
-	assert (m_pConfig != 0);
-	ucVelocity = m_pConfig->MapVelocity (ucVelocity);
-
 	GlobalLock ();
 
-	m_VoiceManager.NoteOn (ucKeyNumber, ucVelocity);
+	m_VoiceManager.SetVoiceStealing (Policy, bRetrigger);
 
 	GlobalUnlock ();
 }
 
-void CMiniSynthesizer::NoteOff (u8 ucKeyNumber)
+void CMiniSynthesizer::SetCullLevel (unsigned nLevelDB)
 {
 	GlobalLock ();
 
-	m_VoiceManager.NoteOff (ucKeyNumber);
+	m_VoiceManager.SetCullLevel (nLevelDB);
 
 	GlobalUnlock ();
 }
 
+void CMiniSynthesizer::NoteOn (u8 ucKeyNumber, u8 ucVelocity)
+{
+	// apply velocity curve
+	assert (m_pConfig != 0);
+	ucVelocity = m_pConfig->MapVelocity (ucVelocity);
+
+	PostEvent (SynthEventNoteOn, ucKeyNumber, ucVelocity);
+}
+
+void CMiniSynthesizer::NoteOff (u8 ucKeyNumber)
+{
+	PostEvent (SynthEventNoteOff, ucKeyNumber);
+}
+
 boolean CMiniSynthesizer::ConfigUpdated (void)
 {
 	unsigned nConfigRevisionWrite = m_nConfigRevisionWrite;
@@ -124,6 +219,11 @@ boolean CMiniSynthesizer::ConfigUpdated (void)
 	return FALSE;
 }
 
+u32 CMiniSynthesizer::ParametersUpdated (void)
+{
+	return __atomic_exchange_n (&m_nUpdatedParameters, 0, __ATOMIC_RELAXED);
+}
+
 void CMiniSynthesizer::ControlChange (u8 ucFunction, u8 ucValue)
 {
 	assert (m_pConfig != 0);
@@ -133,70 +233,537 @@ void CMiniSynthesizer::ControlChange (u8 ucFunction, u8 ucValue)
 		return;
 	}
 
-	GlobalLock ();
+	PostEvent (SynthEventControlChange, Parameter, ucValue);
+}
 
-	CPatch *pPatch = m_pConfig->GetActivePatch ();
-	assert (pPatch != 0);
+void CMiniSynthesizer::ProgramChange (u8 ucProgram)
+{
+	assert (m_pConfig != 0);
 
-	pPatch->SetMIDIParameter (Parameter, ucValue);
-	SetPatch (pPatch);
+	if (ucProgram >= PATCHES)
+	{
+		return;
+	}
+
+	GlobalLock ();
 
+	// the patch is compiled here (like in SetPatch()), but picked up at the event
+	m_pConfig->SetActivePatchNumber (ucProgram);
+	m_pPendingPatch = m_pConfig->GetActivePatch ();
+	m_PatchCompiler.Publish (m_pPendingPatch);
+	m_nChangedParameters = 0;
+	m_nProgramChanges++;
 	m_nConfigRevisionWrite++;
 
 	GlobalUnlock ();
+
+	if (!PostEvent (SynthEventProgramChange, ucProgram))
+	{
+		// the patch is picked up before the next part then
+		GlobalLock ();
+		m_nProgramChanges--;
+		GlobalUnlock ();
+	}
 }
 
-void CMiniSynthesizer::ProgramChange (u8 ucProgram)
+#ifdef SHOW_STATUS
+
+const char *CMiniSynthesizer::GetStatus (void)
 {
-	assert (m_pConfig != 0);
+	m_Status.Format ("%u ms, MIDI queue %u/%u, %u lost", m_nMaxDelayTicks * 1000 / CLOCKHZ,
+			 m_EventQueue.GetHighWaterMark (), EVENT_QUEUE_SIZE,
+			 m_EventQueue.GetOverflowCount ());
+
+	if (m_nRenderAheadChunks > 0)
+	{
+		CString Underruns;
+		Underruns.Format (", %u underruns", m_nUnderrunCount);
+		m_Status.Append (Underruns);
+	}
+
+	return m_Status;
+}
+
+#endif
 
+void CMiniSynthesizer::BeginChunk (unsigned nFrames)
+{
+	assert (nFrames > 0);
+
+	// the chunks rendered ahead must fit into the ring
+	unsigned nAheadChunks = m_nRenderAheadChunks;
+	if (nAheadChunks > RENDER_RING_FRAMES / nFrames)
+	{
+		nAheadChunks = RENDER_RING_FRAMES / nFrames;
+	}
+
+	GlobalLock ();				// GetChunk() may be called from task context too
+
+	m_nChunkClock = m_nPlayClock;
+	m_nChunkFrames = nFrames;
+	m_nRenderAheadFrames = nAheadChunks * nFrames;
+	m_nChunkTicks = CTimer::GetClockTicks ();
+
+	GlobalUnlock ();
+
+	CCoreSync::SendEvent ();		// RENDER_CORE may wait for the chunk size
+}
+
+unsigned CMiniSynthesizer::PeekFrames (unsigned nMaxFrames, const float **ppLeft,
+				       const float **ppRight)
+{
+	assert (nMaxFrames > 0);
+	assert (ppLeft != 0);
+	assert (ppRight != 0);
+
+	if (nMaxFrames > MAX_FRAMES_PER_CHUNK)
+	{
+		nMaxFrames = MAX_FRAMES_PER_CHUNK;
+	}
+
+	if (   m_nRenderAheadChunks == 0
+	    && m_RenderRing.GetFilled () == 0)
+	{
+		RenderFrames (nMaxFrames);
+
+		assert (m_VoiceManager.GetPendingFrames () == 0);	// no EFFECTS_CORE
+	}
+
+	unsigned nFrames = m_RenderRing.Peek (ppLeft, ppRight, nMaxFrames);
+	if (nFrames > 0)
+	{
+		m_bUnderrun = FALSE;
+
+		return nFrames;
+	}
+
+	// the renderer is late, the rest of the chunk is silence
+	assert (m_nRenderAheadChunks > 0);
+	m_bUnderrun = TRUE;
+	m_nUnderrunCount++;
+
+	*ppLeft = Silence;
+	*ppRight = Silence;
+
+	return nMaxFrames;
+}
+
+void CMiniSynthesizer::ConsumeFrames (unsigned nFrames)
+{
+	if (m_bUnderrun)
+	{
+		return;
+	}
+
+	m_RenderRing.Consume (nFrames);
+
+	// the events are timed on the frames, which have been played actually
+	m_nPlayClock += nFrames;
+}
+
+void CMiniSynthesizer::RenderFrames (unsigned nFrames)
+{
+	assert (nFrames + m_VoiceManager.GetPendingFrames () <= m_RenderRing.GetFree ());
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	m_VoiceManager.SetEffectsCore (__atomic_load_n (&m_bEffectsCore, __ATOMIC_RELAXED));
+#endif
+
+	while (nFrames > 0)
+	{
+		unsigned nPart = nFrames;
+		if (nPart > MAX_FRAMES_PER_CHUNK)
+		{
+			nPart = MAX_FRAMES_PER_CHUNK;
+		}
+
+		nPart = ProcessEvents (nPart);
+
+		m_VoiceManager.RenderChunk (nPart, &m_RenderRing);
+
+		nFrames -= nPart;
+	}
+}
+
+#ifdef ARM_ALLOW_MULTI_CORE
+
+boolean CMiniSynthesizer::RenderAhead (void)
+{
+	// the chunk size is known from the first GetChunk() call on
+	unsigned nChunkFrames = __atomic_load_n (&m_nChunkFrames, __ATOMIC_RELAXED);
+	unsigned nAheadFrames = __atomic_load_n (&m_nRenderAheadFrames, __ATOMIC_RELAXED);
+	if (   nChunkFrames == 0
+	    ||   m_RenderRing.GetFilled () + m_VoiceManager.GetPendingFrames () + nChunkFrames
+	       > nAheadFrames)
+	{
+		return FALSE;
+	}
+
+	RenderFrames (nChunkFrames);
+
+	return TRUE;
+}
+
+boolean CMiniSynthesizer::RenderAheadHandler (void *pParam)
+{
+	CMiniSynthesizer *pThis = (CMiniSynthesizer *) pParam;
+	assert (pThis != 0);
+
+	return pThis->RenderAhead ();
+}
+
+#endif
+
+unsigned CMiniSynthesizer::ProcessEvents (unsigned nMaxFrames)
+{
+	assert (nMaxFrames > 0);
+
+	// a patch from SetPatch() applies at once, one from ProgramChange() at its event
+	PickUpPatch (FALSE);
+
+	// the MIDI CCs, which are due at the same frame, are applied once per
+	// parameter with the latest value, before the next other event
+	u32 nParameters = 0;
+	u8 ucValue[SynthParameterUnknown];
+
+	TSynthEvent Event;
+	while (m_EventQueue.Peek (&Event))
+	{
+		// render up to the next event, which is not due yet
+		int nDelay = (int) (Event.nTimestamp - m_nSampleClock);
+		if (nDelay > 0)
+		{
+			if ((unsigned) nDelay < nMaxFrames)
+			{
+				nMaxFrames = nDelay;
+			}
+
+			break;
+		}
+
+		m_EventQueue.Dequeue (&Event);
+
+		if (Event.Type == SynthEventControlChange)
+		{
+			assert (Event.ucParam1 < SynthParameterUnknown);
+			ucValue[Event.ucParam1] = Event.ucParam2;
+			nParameters |= 1U << Event.ucParam1;
+
+			continue;
+		}
+
+		if (nParameters != 0)
+		{
+			ApplyControlChanges (nParameters, ucValue);
+			nParameters = 0;
+		}
+
+		switch (Event.Type)
+		{
+		case SynthEventNoteOn:
+			m_VoiceManager.NoteOn (Event.ucParam1, Event.ucParam2);
+			break;
+
+		case SynthEventNoteOff:
+			m_VoiceManager.NoteOff (Event.ucParam1);
+			break;
+
+		case SynthEventProgramChange:
+			PickUpPatch (TRUE);
+			break;
+
+		default:
+			assert (0);
+			break;
+		}
+	}
+
+	if (nParameters != 0)
+	{
+		ApplyControlChanges (nParameters, ucValue);
+	}
+
+	m_nSampleClock += nMaxFrames;
+
+	return nMaxFrames;
+}
+
+void CMiniSynthesizer::PickUpPatch (boolean bProgramChange)
+{
+	// SetPatch() and ProgramChange() may publish a patch on core 0 meanwhile
 	GlobalLock ();
 
-	if (ucProgram < PATCHES)
+	// only the last one of several program changes in flight is picked up
+	const TCompiledPatch *pPatch = 0;
+	if (bProgramChange)
 	{
-		m_pConfig->SetActivePatchNumber (ucProgram);
-		SetPatch (m_pConfig->GetActivePatch ());
-		m_nConfigRevisionWrite++;
+		assert (m_nProgramChanges > 0);
+		m_nProgramChanges--;
+	}
+
+	if (m_nProgramChanges == 0)
+	{
+		pPatch = m_PatchCompiler.PickUp ();
+		if (pPatch != 0)
+		{
+			m_pActivePatch = m_pPendingPatch;
+
+			// the MIDI CCs applied since it has been published
+			if (m_nChangedParameters != 0)
+			{
+				pPatch = m_PatchCompiler.Update (m_pActivePatch, m_nChangedParameters);
+				m_nChangedParameters = 0;
+			}
+		}
 	}
 
 	GlobalUnlock ();
+
+	if (pPatch != 0)
+	{
+		m_VoiceManager.SetPatch (pPatch);
+	}
 }
 
-#ifdef SHOW_STATUS
+void CMiniSynthesizer::ApplyControlChanges (u32 nParameters, const u8 *pValue)
+{
+	assert (nParameters != 0);
+	assert (pValue != 0);
 
-const char *CMiniSynthesizer::GetStatus (void)
+	// the GUI may read the patch on core 0 meanwhile
+	GlobalLock ();
+
+	const TCompiledPatch *pPatch = 0;
+	if (m_pActivePatch != 0)
+	{
+		for (unsigned i = 0; i < SynthParameterUnknown; i++)
+		{
+			if (nParameters & (1U << i))
+			{
+				m_pActivePatch->SetMIDIParameter ((TSynthParameter) i, pValue[i]);
+			}
+		}
+
+		// only the modules, which depend on the parameters, are compiled
+		pPatch = m_PatchCompiler.Update (m_pActivePatch, nParameters);
+		m_nChangedParameters |= nParameters;
+	}
+
+	GlobalUnlock ();
+
+	if (pPatch != 0)
+	{
+		m_VoiceManager.SetPatch (pPatch);
+
+		__atomic_fetch_or (&m_nUpdatedParameters, nParameters, __ATOMIC_RELAXED);
+	}
+}
+
+boolean CMiniSynthesizer::PostEvent (TSynthEventType Type, u8 ucParam1, u8 ucParam2)
 {
-	m_Status.Format ("%u ms", m_nMaxDelayTicks * 1000 / CLOCKHZ);
+	TSynthEvent Event;
+	Event.Type = Type;
+	Event.ucParam1 = ucParam1;
+	Event.ucParam2 = ucParam2;
 
-	return m_Status;
+	// the USB IRQ handler and the serial MIDI device (in task context) are
+	// producers, only one of them may access the queue at a time
+	GlobalLock ();
+
+	// apply the event in the next chunk (after the chunks rendered ahead) at the
+	// same offset, it arrived after the start of the last chunk (until GetChunk()
+	// has been called first, m_nChunkFrames is 0 and the event applies immediately)
+	unsigned nOffset = 0;
+	if (m_nChunkFrames > 0)
+	{
+		u64 nTicks = CTimer::GetClockTicks () - m_nChunkTicks;
+		nOffset = (unsigned) (nTicks * CSampleRate::Get () / CLOCKHZ);
+		if (nOffset >= m_nChunkFrames)			// GetChunk() is late
+		{
+			nOffset = m_nChunkFrames-1;
+		}
+	}
+
+	Event.nTimestamp = m_nChunkClock + m_nChunkFrames + m_nRenderAheadFrames + nOffset;
+
+	boolean bOK = m_EventQueue.Enqueue (Event);
+
+	GlobalUnlock ();
+
+	return bOK;
+}
+
+unsigned CMiniSynthesizer::GetChunkFrames (void) const
+{
+	return __atomic_load_n (&m_nChunkFrames, __ATOMIC_RELAXED);
 }
 
+void CMiniSynthesizer::CheckChunkSize (unsigned nChunkFrames)
+{
+	assert (nChunkFrames > 0);
+
+	// like in BeginChunk()
+	unsigned nAheadChunks = m_nRenderAheadChunks;
+	if (nAheadChunks > RENDER_RING_FRAMES / nChunkFrames)
+	{
+		nAheadChunks = RENDER_RING_FRAMES / nChunkFrames;
+	}
+
+	// an event is delayed by one chunk and by the chunks rendered ahead,
+	// the DMA plays one chunk, while the next one is filled
+	unsigned nChunkUs = nChunkFrames * 1000000U / CSampleRate::Get ();
+	unsigned nQueuedChunks = 2 + nAheadChunks;
+
+	CLogger::Get ()->Write (FromMiniSynth, LogNotice,
+				"Chunk of %u frames (%u us), %u chunks queued, latency %u us",
+				nChunkFrames, nChunkUs, nQueuedChunks, nQueuedChunks * nChunkUs);
+
+	unsigned nVoiceTicks, nReverbTicks;
+	MeasureRenderTicks (nChunkFrames, &nVoiceTicks, &nReverbTicks);
+
+	// the voice groups are shared among the cores, which render voices
+	unsigned nCores = 1;
+	boolean bEffectsCore = FALSE;
+#ifdef ARM_ALLOW_MULTI_CORE
+	nCores = CORES;
+	if (nAheadChunks > 0)
+	{
+		nCores--;				// core 0 only converts the chunks
+	}
+
+	bEffectsCore = m_bEffectsCore;
+	if (bEffectsCore)
+	{
+		nCores--;
+	}
 #endif
 
+	u64 nTicks = (u64) nVoiceTicks * ((GROUPS + nCores-1) / nCores) / VOICE_GROUPS;
+	if (   !bEffectsCore
+	    || m_nRenderAheadChunks == 0)		// GetChunk() waits for the reverb
+	{
+		nTicks += nReverbTicks;
+	}
+	else if (nTicks < nReverbTicks)
+	{
+		nTicks = nReverbTicks;			// the reverb runs in parallel
+	}
+
+	unsigned nRenderUs = (unsigned) (nTicks * 1000000 / CLOCKHZ);
+	if (nRenderUs < nChunkUs)
+	{
+		CLogger::Get ()->Write (FromMiniSynth, LogNotice,
+					"Rendering a chunk takes up to %u us, %u us are left",
+					nRenderUs, nChunkUs - nRenderUs);
+	}
+	else
+	{
+		CLogger::Get ()->Write (FromMiniSynth, LogWarning,
+					"Rendering a chunk takes up to %u us, longer than it lasts",
+					nRenderUs);
+	}
+}
+
+void CMiniSynthesizer::MeasureRenderTicks (unsigned nFrames, unsigned *pVoiceTicks,
+					   unsigned *pReverbTicks)
+{
+	assert (pVoiceTicks != 0);
+	assert (pReverbTicks != 0);
+
+	assert (m_pConfig != 0);
+	CPatch *pPatch = m_pConfig->GetActivePatch ();
+	assert (pPatch != 0);
+
+	TCompiledPatch *pCompiledPatch = new TCompiledPatch;
+	CPatchCompiler::Compile (pPatch, pCompiledPatch);
+
+	// placed on a cache line boundary like in CVoiceManager
+	u8 *pVoiceBankBuffer = new u8[sizeof (CVoiceBank) + CACHE_LINE_SIZE-1];
+	assert (pVoiceBankBuffer != 0);
+	uintptr nBank =   ((uintptr) pVoiceBankBuffer + CACHE_LINE_SIZE-1)
+			& ~((uintptr) CACHE_LINE_SIZE-1);
+	CVoiceBank *pVoiceBank = new ((void *) nBank) CVoiceBank;
+	pVoiceBank->SetPatch (pCompiledPatch);
+
+	for (unsigned nVoice = 0; nVoice < VOICES_PER_CORE; nVoice++)
+	{
+		pVoiceBank->NoteOn (nVoice, 48 + nVoice*5 % 48, 127);
+	}
+
+	CReverbModule *pReverbModule = new CReverbModule;
+	pReverbModule->SetParameters (&pCompiledPatch->Reverb);
+
+	u32 nVoices = (u32) ((1ULL << VOICES_PER_CORE) - 1);
+
+	float Buffer[FRAMES_PER_BLOCK];
+	float OutputLeft[FRAMES_PER_BLOCK];
+	float OutputRight[FRAMES_PER_BLOCK];
+
+	// the first run warms the caches up
+	for (unsigned nRun = 0; nRun < 2; nRun++)
+	{
+		*pVoiceTicks = 0;
+		*pReverbTicks = 0;
+
+		for (unsigned nFrame = 0; nFrame < nFrames; nFrame += FRAMES_PER_BLOCK)
+		{
+			unsigned nBlock = nFrames - nFrame;
+			if (nBlock > FRAMES_PER_BLOCK)
+			{
+				nBlock = FRAMES_PER_BLOCK;
+			}
+
+			unsigned nStartTicks = CTimer::GetClockTicks ();
+
+			for (unsigned i = 0; i < nBlock; i++)
+			{
+				Buffer[i] = 0.0f;
+			}
+
+			pVoiceBank->RenderBlock (nVoices, Buffer, nBlock);
+
+			unsigned nVoiceTicks = CTimer::GetClockTicks ();
+			*pVoiceTicks += nVoiceTicks - nStartTicks;
+
+			pReverbModule->RenderBlock (Buffer, OutputLeft, OutputRight, nBlock);
+
+			*pReverbTicks += CTimer::GetClockTicks () - nVoiceTicks;
+		}
+	}
+
+	delete pReverbModule;
+	pVoiceBank->~CVoiceBank ();
+	delete [] pVoiceBankBuffer;
+	delete pCompiledPatch;
+}
+
 void CMiniSynthesizer::GlobalLock (void)
 {
-	EnterCritical (IRQ_LEVEL);
+	m_SpinLock.Acquire ();
 }
 
 void CMiniSynthesizer::GlobalUnlock (void)
 {
-	LeaveCritical ();
+	m_SpinLock.Release ();
 }
 
 //// PWM //////////////////////////////////////////////////////////////////////
 
 CMiniSynthesizerPWM::CMiniSynthesizerPWM (CSynthConfig *pConfig,
-					  CInterruptSystem *pInterrupt)
+					  CInterruptSystem *pInterrupt,
+					  unsigned nChunkFrames)
 :	CMiniSynthesizer (pConfig, pInterrupt),
-	CPWMSoundBaseDevice (pInterrupt, SAMPLE_RATE),
-	m_nMaxLevel (GetRangeMax ()-1),
-	m_nNullLevel (m_nMaxLevel / 2),
-	m_bChannelsSwapped (AreChannelsSwapped ())
+	CPWMSoundBaseDevice (pInterrupt, CSampleRate::Get (), nChunkFrames * 2),
+	m_nChunkSize (nChunkFrames * 2),
+	m_Converter (SampleFormatInt32, (GetRangeMax ()-1) / 2.0f, (GetRangeMax ()-1) / 2,
+		     0, GetRangeMax ()-1, AreChannelsSwapped ())
 {
 }
 
 boolean CMiniSynthesizerPWM::Start (void)
 {
+	CheckChunkSize (m_nChunkSize / 2);
+
 	return CPWMSoundBaseDevice::Start ();
 }
 
@@ -211,49 +778,21 @@ unsigned CMiniSynthesizerPWM::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	unsigned nTicks = CTimer::GetClockTicks ();
 #endif
 
-	GlobalLock ();
-
 	unsigned nResult = nChunkSize;
 
-	float fVolumeLevel = m_fVolume * m_nMaxLevel/2;
+	BeginChunk (nChunkSize / 2);
 
-	for (; nChunkSize > 0; nChunkSize -= 2)		// fill the whole buffer
+	while (nChunkSize > 0)				// fill the whole buffer
 	{
-		m_VoiceManager.NextSample ();
+		const float *pLevelLeft;
+		const float *pLevelRight;
+		unsigned nFrames = PeekFrames (nChunkSize / 2, &pLevelLeft, &pLevelRight);
 
-		float fLevelLeft = m_VoiceManager.GetOutputLevelLeft ();
-		int nLevelLeft = (int) (fLevelLeft*fVolumeLevel + m_nNullLevel);
-		if (nLevelLeft > (int) m_nMaxLevel)
-		{
-			nLevelLeft = m_nMaxLevel;
-		}
-		else if (nLevelLeft < 0)
-		{
-			nLevelLeft = 0;
-		}
+		pBuffer = (u32 *) m_Converter.Convert (pLevelLeft, pLevelRight, nFrames, pBuffer);
 
-		float fLevelRight = m_VoiceManager.GetOutputLevelRight ();
-		int nLevelRight = (int) (fLevelRight*fVolumeLevel + m_nNullLevel);
-		if (nLevelRight > (int) m_nMaxLevel)
-		{
-			nLevelRight = m_nMaxLevel;
-		}
-		else if (nLevelRight < 0)
-		{
-			nLevelRight = 0;
-		}
+		ConsumeFrames (nFrames);
 
-		// for 2 stereo channels
-		if (!m_bChannelsSwapped)
-		{
-			*pBuffer++ = (u32) nLevelLeft;
-			*pBuffer++ = (u32) nLevelRight;
-		}
-		else
-		{
-			*pBuffer++ = (u32) nLevelRight;
-			*pBuffer++ = (u32) nLevelLeft;
-		}
+		nChunkSize -= nFrames * 2;
 	}
 
 #ifdef SHOW_STATUS
@@ -264,8 +803,6 @@ unsigned CMiniSynthesizerPWM::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	}
 #endif
 
-	GlobalUnlock ();
-
 	return nResult;
 }
 
@@ -273,17 +810,21 @@ unsigned CMiniSynthesizerPWM::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 
 CMiniSynthesizerI2S::CMiniSynthesizerI2S (CSynthConfig *pConfig,
 					  CInterruptSystem *pInterrupt,
-					  CI2CMaster *pI2CMaster)
+					  CI2CMaster *pI2CMaster,
+					  unsigned nChunkFrames)
 :	CMiniSynthesizer (pConfig, pInterrupt),
-	CI2SSoundBaseDevice (pInterrupt, SAMPLE_RATE, 2048, FALSE, pI2CMaster, DAC_I2C_ADDRESS),
-	m_nMinLevel (GetRangeMin ()+1),
-	m_nMaxLevel (GetRangeMax ()-1),
-	m_bChannelsSwapped (AreChannelsSwapped ())
+	CI2SSoundBaseDevice (pInterrupt, CSampleRate::Get (), nChunkFrames * 2, FALSE,
+			     pI2CMaster, DAC_I2C_ADDRESS),
+	m_nChunkSize (nChunkFrames * 2),
+	m_Converter (SampleFormatInt32, (float) (GetRangeMax ()-1), 0,
+		     GetRangeMin ()+1, GetRangeMax ()-1, AreChannelsSwapped ())
 {
 }
 
 boolean CMiniSynthesizerI2S::Start (void)
 {
+	CheckChunkSize (m_nChunkSize / 2);
+
 	return CI2SSoundBaseDevice::Start ();
 }
 
@@ -298,49 +839,21 @@ unsigned CMiniSynthesizerI2S::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	unsigned nTicks = CTimer::GetClockTicks ();
 #endif
 
-	GlobalLock ();
-
 	unsigned nResult = nChunkSize;
 
-	float fVolumeLevel = m_fVolume * m_nMaxLevel;
+	BeginChunk (nChunkSize / 2);
 
-	for (; nChunkSize > 0; nChunkSize -= 2)		// fill the whole buffer
+	while (nChunkSize > 0)				// fill the whole buffer
 	{
-		m_VoiceManager.NextSample ();
+		const float *pLevelLeft;
+		const float *pLevelRight;
+		unsigned nFrames = PeekFrames (nChunkSize / 2, &pLevelLeft, &pLevelRight);
 
-		float fLevelLeft = m_VoiceManager.GetOutputLevelLeft ();
-		int nLevelLeft = (int) (fLevelLeft*fVolumeLevel);
-		if (nLevelLeft > (int) m_nMaxLevel)
-		{
-			nLevelLeft = m_nMaxLevel;
-		}
-		else if (nLevelLeft < m_nMinLevel)
-		{
-			nLevelLeft = m_nMinLevel;
-		}
+		pBuffer = (u32 *) m_Converter.Convert (pLevelLeft, pLevelRight, nFrames, pBuffer);
 
-		float fLevelRight = m_VoiceManager.GetOutputLevelRight ();
-		int nLevelRight = (int) (fLevelRight*fVolumeLevel);
-		if (nLevelRight > (int) m_nMaxLevel)
-		{
-			nLevelRight = m_nMaxLevel;
-		}
-		else if (nLevelRight < m_nMinLevel)
-		{
-			nLevelRight = m_nMinLevel;
-		}
+		ConsumeFrames (nFrames);
 
-		// for 2 stereo channels
-		if (!m_bChannelsSwapped)
-		{
-			*pBuffer++ = (u32) nLevelLeft;
-			*pBuffer++ = (u32) nLevelRight;
-		}
-		else
-		{
-			*pBuffer++ = (u32) nLevelRight;
-			*pBuffer++ = (u32) nLevelLeft;
-		}
+		nChunkSize -= nFrames * 2;
 	}
 
 #ifdef SHOW_STATUS
@@ -351,8 +864,6 @@ unsigned CMiniSynthesizerI2S::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	}
 #endif
 
-	GlobalUnlock ();
-
 	return nResult;
 }
 
@@ -363,16 +874,37 @@ unsigned CMiniSynthesizerI2S::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 CMiniSynthesizerUSB::CMiniSynthesizerUSB (CSynthConfig *pConfig,
 					  CInterruptSystem *pInterrupt)
 :	CMiniSynthesizer (pConfig, pInterrupt),
-	CUSBSoundBaseDevice (SAMPLE_RATE),
-	m_nMinLevel (GetRangeMin ()+1),
-	m_nMaxLevel (GetRangeMax ()-1),
-	m_bChannelsSwapped (AreChannelsSwapped ())
+	CUSBSoundBaseDevice (CSampleRate::Get ()),
+	m_Converter16 (SampleFormatInt16, (float) (GetRangeMax ()-1), 0,
+		       GetRangeMin ()+1, GetRangeMax ()-1, AreChannelsSwapped ()),
+	m_Converter24 (SampleFormatInt24Packed, (float) (GetRangeMax ()-1), 0,
+		       GetRangeMin ()+1, GetRangeMax ()-1, AreChannelsSwapped ())
 {
 }
 
 boolean CMiniSynthesizerUSB::Start (void)
 {
-	return CUSBSoundBaseDevice::Start ();
+	if (!CUSBSoundBaseDevice::Start ())
+	{
+		return FALSE;
+	}
+
+	// the chunk size follows the USB frames, it is known from the first GetChunk() call
+	unsigned nChunkFrames = 0;
+	for (unsigned i = 0; i < USB_CHUNK_WAIT_MS; i++)
+	{
+		nChunkFrames = GetChunkFrames ();
+		if (nChunkFrames > 0)
+		{
+			CheckChunkSize (nChunkFrames);
+
+			break;
+		}
+
+		CTimer::SimpleMsDelay (1);
+	}
+
+	return TRUE;
 }
 
 boolean CMiniSynthesizerUSB::IsActive (void)
@@ -386,55 +918,24 @@ unsigned CMiniSynthesizerUSB::GetChunk (s16 *pBuffer, unsigned nChunkSize)
 	unsigned nTicks = CTimer::GetClockTicks ();
 #endif
 
-	GlobalLock ();
-
 	unsigned nChannels = GetHWTXChannels ();
 	unsigned nResult = nChunkSize;
 
-	float fVolumeLevel = m_fVolume * m_nMaxLevel;
+	assert (nChannels >= 2);
+	BeginChunk (nChunkSize / nChannels);
 
-	for (; nChunkSize > 0; nChunkSize -= nChannels)		// fill the whole buffer
+	while (nChunkSize > 0)				// fill the whole buffer
 	{
-		m_VoiceManager.NextSample ();
-
-		float fLevelLeft = m_VoiceManager.GetOutputLevelLeft ();
-		int nLevelLeft = (int) (fLevelLeft*fVolumeLevel);
-		if (nLevelLeft > (int) m_nMaxLevel)
-		{
-			nLevelLeft = m_nMaxLevel;
-		}
-		else if (nLevelLeft < m_nMinLevel)
-		{
-			nLevelLeft = m_nMinLevel;
-		}
+		const float *pLevelLeft;
+		const float *pLevelRight;
+		unsigned nFrames = PeekFrames (nChunkSize / nChannels, &pLevelLeft, &pLevelRight);
 
-		float fLevelRight = m_VoiceManager.GetOutputLevelRight ();
-		int nLevelRight = (int) (fLevelRight*fVolumeLevel);
-		if (nLevelRight > (int) m_nMaxLevel)
-		{
-			nLevelRight = m_nMaxLevel;
-		}
-		else if (nLevelRight < m_nMinLevel)
-		{
-			nLevelRight = m_nMinLevel;
-		}
+		pBuffer = (s16 *) m_Converter16.Convert (pLevelLeft, pLevelRight, nFrames,
+							   pBuffer, nChannels);
 
-		assert (nChannels >= 2);
-		if (!m_bChannelsSwapped)
-		{
-			*pBuffer++ = (s16) nLevelLeft;
-			*pBuffer++ = (s16) nLevelRight;
-		}
-		else
-		{
-			*pBuffer++ = (s16) nLevelRight;
-			*pBuffer++ = (s16) nLevelLeft;
-		}
+		ConsumeFrames (nFrames);
 
-		for (unsigned i = 2; i < nChannels; i++)
-		{
-			*pBuffer++ = 0;
-		}
+		nChunkSize -= nFrames * nChannels;
 	}
 
 #ifdef SHOW_STATUS
@@ -445,8 +946,6 @@ unsigned CMiniSynthesizerUSB::GetChunk (s16 *pBuffer, unsigned nChunkSize)
 	}
 #endif
 
-	GlobalUnlock ();
-
 	return nResult;
 }
 
@@ -456,60 +955,26 @@ unsigned CMiniSynthesizerUSB::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	unsigned nTicks = CTimer::GetClockTicks ();
 #endif
 
-	GlobalLock ();
-
 	unsigned nChannels = GetHWTXChannels ();
 	unsigned nResult = nChunkSize;
 
-	float fVolumeLevel = m_fVolume * m_nMaxLevel;
+	assert (nChannels >= 2);
+	BeginChunk (nChunkSize / nChannels);
 
-	for (; nChunkSize > 0; nChunkSize -= nChannels)		// fill the whole buffer
-	{
-		m_VoiceManager.NextSample ();
+	u8 *pOutput = (u8 *) pBuffer;			// the 24-bit samples are packed
 
-		float fLevelLeft = m_VoiceManager.GetOutputLevelLeft ();
-		int nLevelLeft = (int) (fLevelLeft*fVolumeLevel);
-		if (nLevelLeft > (int) m_nMaxLevel)
-		{
-			nLevelLeft = m_nMaxLevel;
-		}
-		else if (nLevelLeft < m_nMinLevel)
-		{
-			nLevelLeft = m_nMinLevel;
-		}
+	while (nChunkSize > 0)				// fill the whole buffer
+	{
+		const float *pLevelLeft;
+		const float *pLevelRight;
+		unsigned nFrames = PeekFrames (nChunkSize / nChannels, &pLevelLeft, &pLevelRight);
 
-		float fLevelRight = m_VoiceManager.GetOutputLevelRight ();
-		int nLevelRight = (int) (fLevelRight*fVolumeLevel);
-		if (nLevelRight > (int) m_nMaxLevel)
-		{
-			nLevelRight = m_nMaxLevel;
-		}
-		else if (nLevelRight < m_nMinLevel)
-		{
-			nLevelRight = m_nMinLevel;
-		}
+		pOutput = (u8 *) m_Converter24.Convert (pLevelLeft, pLevelRight, nFrames,
+							  pOutput, nChannels);
 
-		assert (nChannels >= 2);
-		if (!m_bChannelsSwapped)
-		{
-			*pBuffer = (u32) nLevelLeft;
-			pBuffer = (u32 *) ((u8 *) pBuffer + 3);
-			*pBuffer = (u32) nLevelRight;
-			pBuffer = (u32 *) ((u8 *) pBuffer + 3);
-		}
-		else
-		{
-			*pBuffer = (u32) nLevelRight;
-			pBuffer = (u32 *) ((u8 *) pBuffer + 3);
-			*pBuffer = (u32) nLevelLeft;
-			pBuffer = (u32 *) ((u8 *) pBuffer + 3);
-		}
+		ConsumeFrames (nFrames);
 
-		for (unsigned i = 2; i < nChannels; i++)
-		{
-			*pBuffer = 0;
-			pBuffer = (u32 *) ((u8 *) pBuffer + 3);
-		}
+		nChunkSize -= nFrames * nChannels;
 	}
 
 #ifdef SHOW_STATUS
@@ -520,8 +985,6 @@ unsigned CMiniSynthesizerUSB::GetChunk (u32 *pBuffer, unsigned nChunkSize)
 	}
 #endif
 
-	GlobalUnlock ();
-
 	return nResult;
 }
 
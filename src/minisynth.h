@@ -2,7 +2,7 @@
 // minisynth.h
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2024  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,6 +25,7 @@
 #include <circle/sound/pwmsoundbasedevice.h>
 #include <circle/sound/i2ssoundbasedevice.h>
 #include <circle/sound/usbsoundbasedevice.h>
+#include <circle/spinlock.h>
 #include <circle/string.h>
 #include <circle/types.h>
 #include "synthconfig.h"
@@ -33,14 +34,40 @@
 #include "pckeyboard.h"
 #include "serialmididevice.h"
 #include "voicemanager.h"
+#include "eventqueue.h"
+#include "renderring.h"
+#include "sampleconverter.h"
+#include "patchcompiler.h"
 #include "config.h"
 
-// That all runs on core 0. SetPatch() gets called from the GUI and may be
-// interrupted by the other routines. NoteOn/Off() is IRQ-triggered by the USB IRQ
-// handler. GetChunk() is IRQ-triggered by the PWM DMA IRQ handler. IRQ handlers
-// cannot be interrupted again. Thus the execution of these routines (except
-// SetPatch()) is mutual-exclusive. There is no need for explicit synchronization,
-// but setting a single parameter in SetPatch() must be atomic.
+// That all runs on core 0 (but see below). SetPatch() gets called from the GUI
+// and may be interrupted by the other routines. NoteOn/Off(), ControlChange() and
+// ProgramChange() are IRQ-triggered by the USB IRQ handler or called from the
+// serial MIDI device in task context. They only post an event to the event
+// queue, which GetChunk() (IRQ-triggered by the DMA IRQ handler) drains while
+// rendering the chunk, so that the events apply in their order. SetPatch()
+// compiles the patch and publishes it (see CPatchCompiler), GetChunk() picks it
+// up before it renders the next part. ProgramChange() does the same, but the
+// patch is picked up at its event only. At a MIDI CC event GetChunk() sets the
+// parameter in the patch and compiles the modules, which depend on it. The CCs
+// due at the same frame are applied once per parameter with the latest value.
+// Only posting an event, SetPatch(), picking up the patch and compiling the
+// modules need a (short) critical section.
+//
+// An event is stamped with the frame of the sample clock, where it applies. It
+// is delayed by one chunk, but keeps its position relative to the GetChunk()
+// calls, so that its timing does not depend on the chunk size. The chunk is
+// rendered in parts, which end at the frames of the events, into m_RenderRing
+// with the volume applied, from where GetChunk() converts it to the output format
+// with a CSampleConverter.
+// The reverb may run on its own core (see SetEffectsCore() and CVoiceManager).
+//
+// With SetRenderAhead() the chunks are rendered on RENDER_CORE instead (see
+// CVoiceManager), which processes the events and keeps up to the given number of
+// chunks in m_RenderRing, so that GetChunk() only has to convert them and a late
+// chunk does not miss the DMA deadline at once. The events are delayed by these
+// chunks in addition. If a chunk is not ready in time, it is output as silence
+// and counted as underrun. The critical section is a spin lock then.
 
 class CMiniSynthesizer
 {
@@ -50,6 +77,13 @@ public:
 
 	boolean Initialize (void);
 
+	// renders nChunks chunks ahead on RENDER_CORE (0 to render in GetChunk()),
+	// must be called before Start()
+	void SetRenderAhead (unsigned nChunks);
+	// runs the reverb on EFFECTS_CORE (or not), may be called at any time,
+	// but requires rendering ahead
+	void SetEffectsCore (boolean bOn);
+
 	virtual boolean Start (void) = 0;
 	virtual boolean IsActive (void) = 0;
 
@@ -57,10 +91,15 @@ public:
 
 	void SetPatch (CPatch *pPatch);
 
+	void SetVoiceStealing (TVoiceStealing Policy, boolean bRetrigger = TRUE);
+	void SetCullLevel (unsigned nLevelDB);		// dB below full scale (0 to disable)
+
 	void NoteOn (u8 ucKeyNumber, u8 ucVelocity = VELOCITY_DEFAULT);	// MIDI key number and velocity
 	void NoteOff (u8 ucKeyNumber);
 
 	boolean ConfigUpdated (void);
+	// returns the parameters changed by MIDI CC since the last call (bit 1 << TSynthParameter)
+	u32 ParametersUpdated (void);
 	void ControlChange (u8 ucFunction, u8 ucValue);
 	void ProgramChange (u8 ucProgram);
 
@@ -69,9 +108,48 @@ public:
 #endif
 
 protected:
+	// called from GetChunk() only
+	void BeginChunk (unsigned nFrames);
+	// returns the number of the next frames to be output (<= nMaxFrames) with
+	// the volume applied, which have to be consumed after conversion
+	unsigned PeekFrames (unsigned nMaxFrames, const float **ppLeft, const float **ppRight);
+	void ConsumeFrames (unsigned nFrames);
+
+	// called when the sound device is started, logs the latency and warns,
+	// if rendering a chunk with all voices takes longer than playing it
+	void CheckChunkSize (unsigned nChunkFrames);
+	// returns the size of the last chunk, 0 before the first GetChunk() call
+	unsigned GetChunkFrames (void) const;
+
 	void GlobalLock (void);
 	void GlobalUnlock (void);
 
+private:
+	// renders nFrames into m_RenderRing in parts, which end at the events
+	void RenderFrames (unsigned nFrames);
+	// applies the events due at the current frame, returns the number of frames
+	// to be rendered next (<= nMaxFrames) and advances the sample clock by it
+	unsigned ProcessEvents (unsigned nMaxFrames);
+
+	// returns the time to render nFrames, while all voices of a bank hold a note
+	// of the active patch, and the time of the reverb for them
+	void MeasureRenderTicks (unsigned nFrames, unsigned *pVoiceTicks, unsigned *pReverbTicks);
+
+#ifdef ARM_ALLOW_MULTI_CORE
+	boolean RenderAhead (void);			// runs on RENDER_CORE
+	static boolean RenderAheadHandler (void *pParam);
+#endif
+
+	// picks up the published patch, if no program change is in flight,
+	// called with bProgramChange at the event of a program change
+	void PickUpPatch (boolean bProgramChange);
+	// sets the parameters (bit 1 << TSynthParameter) to pValue[] in the active
+	// patch and compiles the modules, which depend on them
+	void ApplyControlChanges (u32 nParameters, const u8 *pValue);
+
+	// returns FALSE, if the event queue is full
+	boolean PostEvent (TSynthEventType Type, u8 ucParam1, u8 ucParam2 = 0);
+
 private:
 	CSynthConfig *m_pConfig;
 
@@ -85,13 +163,40 @@ private:
 	unsigned m_nConfigRevisionWrite;
 	unsigned m_nConfigRevisionRead;
 
-protected:
+	CEventQueue m_EventQueue;
+
+	CPatchCompiler m_PatchCompiler;
+
+	CPatch *m_pPendingPatch;		// published in m_PatchCompiler
+	CPatch *m_pActivePatch;			// picked up by the renderer
+	unsigned m_nProgramChanges;		// posted, but not reached by the renderer
+	u32 m_nChangedParameters;		// by MIDI CC since the patch has been published
+	u32 m_nUpdatedParameters;		// by MIDI CC, not shown in the GUI yet
+
+	u32 m_nSampleClock;			// next frame to be rendered
+	u32 m_nPlayClock;			// next frame to be output
+	u32 m_nChunkClock;			// first frame of the last chunk
+	unsigned m_nChunkFrames;		// size of the last chunk
+	unsigned m_nChunkTicks;			// time of the last GetChunk() call
+
+	unsigned m_nRenderAheadChunks;		// 0 if rendering in GetChunk()
+	unsigned m_nRenderAheadFrames;		// for the size of the last chunk
+	CRenderRing m_RenderRing;
+	boolean m_bUnderrun;			// the peeked frames are silence
+	unsigned m_nUnderrunCount;
+
+	boolean m_bEffectsCore;			// requested
+
 	CVoiceManager m_VoiceManager;
 
-	float m_fVolume;
+	CSpinLock m_SpinLock;
 
 #ifdef SHOW_STATUS
 	CString m_Status;
+#endif
+
+protected:
+#ifdef SHOW_STATUS
 	unsigned m_nMaxDelayTicks;
 #endif
 };
@@ -101,7 +206,8 @@ protected:
 class CMiniSynthesizerPWM : public CMiniSynthesizer, public CPWMSoundBaseDevice
 {
 public:
-	CMiniSynthesizerPWM (CSynthConfig *pConfig, CInterruptSystem *pInterrupt);
+	CMiniSynthesizerPWM (CSynthConfig *pConfig, CInterruptSystem *pInterrupt,
+			     unsigned nChunkFrames = CHUNK_FRAMES);
 
 	boolean Start (void);
 	boolean IsActive (void);
@@ -110,9 +216,8 @@ private:
 	unsigned GetChunk (u32 *pBuffer, unsigned nChunkSize);
 
 private:
-	unsigned m_nMaxLevel;
-	unsigned m_nNullLevel;
-	boolean m_bChannelsSwapped;
+	unsigned m_nChunkSize;				// in words
+	CSampleConverter m_Converter;			// offset binary
 };
 
 //// I2S //////////////////////////////////////////////////////////////////////
@@ -121,7 +226,7 @@ class CMiniSynthesizerI2S : public CMiniSynthesizer, public CI2SSoundBaseDevice
 {
 public:
 	CMiniSynthesizerI2S (CSynthConfig *pConfig, CInterruptSystem *pInterrupt,
-			     CI2CMaster *pI2CMaster);
+			     CI2CMaster *pI2CMaster, unsigned nChunkFrames = CHUNK_FRAMES);
 
 	boolean Start (void);
 	boolean IsActive (void);
@@ -130,9 +235,8 @@ private:
 	unsigned GetChunk (u32 *pBuffer, unsigned nChunkSize);
 
 private:
-	int m_nMinLevel;
-	int m_nMaxLevel;
-	boolean m_bChannelsSwapped;
+	unsigned m_nChunkSize;				// in words
+	CSampleConverter m_Converter;
 };
 
 //// USB //////////////////////////////////////////////////////////////////////
@@ -152,9 +256,8 @@ private:
 	unsigned GetChunk (u32 *pBuffer, unsigned nChunkSize);
 
 private:
-	int m_nMinLevel;
-	int m_nMaxLevel;
-	boolean m_bChannelsSwapped;
+	CSampleConverter m_Converter16;
+	CSampleConverter m_Converter24;
 };
 
 #endif
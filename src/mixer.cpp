@@ -2,7 +2,7 @@
 // mixer.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2020-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -20,28 +20,25 @@
 #include "mixer.h"
 #include <assert.h>
 
-CMixer::CMixer (CSynthModule *pInput1, CSynthModule *pInput2)
-:	m_pInput1 (pInput1),
-	m_pInput2 (pInput2),
-	m_fOutputLevel (0.0)
+CMixer::CMixer (void)
 {
 }
 
 CMixer::~CMixer (void)
 {
-	m_pInput1 = 0;
-	m_pInput2 = 0;
 }
 
-void CMixer::NextSample (void)
+void CMixer::RenderBlock (float *pBuffer, unsigned nFrames, const float *pInput1,
+			  const float *pInput2) const
 {
-	assert (m_pInput1 != 0);
-	assert (m_pInput2 != 0);
+	assert (pBuffer != 0);
+	assert (pInput1 != 0);
+	assert (pInput2 != 0);
 
-	m_fOutputLevel = (m_pInput1->GetOutputLevel () + m_pInput2->GetOutputLevel ()) / 2.0;
-}
-
-float CMixer::GetOutputLevel (void) const
-{
-	return m_fOutputLevel;
+	TVector Half = VectorSet (0.5f);
+	for (unsigned i = 0; i < nFrames * VECTOR_LANES; i += VECTOR_LANES)
+	{
+		VectorStore (&pBuffer[i], VectorMul (VectorAdd (VectorLoad (&pInput1[i]),
+								VectorLoad (&pInput2[i])), Half));
+	}
 }
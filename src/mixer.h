@@ -2,7 +2,7 @@
 // mixer.h
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2020-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -20,22 +20,19 @@
 #ifndef _mixer_h
 #define _mixer_h
 
-#include "synthmodule.h"
+#include "simd.h"
 
-class CMixer : public CSynthModule
+// Mixes two blocks of a voice group (see COscillator), it has no state, so that
+// one mixer serves all voices
+
+class CMixer
 {
 public:
-	CMixer (CSynthModule *pInput1, CSynthModule *pInput2);
+	CMixer (void);
 	~CMixer (void);
 
-	void NextSample (void);
-	float GetOutputLevel (void) const;		// returns [-1.0, 1.0]
-
-private:
-	CSynthModule *m_pInput1;
-	CSynthModule *m_pInput2;
-
-	float m_fOutputLevel;
+	void RenderBlock (float *pBuffer, unsigned nFrames, const float *pInput1,
+			  const float *pInput2) const;
 };
 
 #endif
@@ -2,7 +2,7 @@
 // oscillator.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -19,159 +19,229 @@
 //
 #include "oscillator.h"
 #include "config.h"
+#include "wavetable.h"
+#include "samplerate.h"
 #include "math.h"
 #include <assert.h>
 
-#define SINE_POINTS	360
+#define PHASE_RANGE	4294967296.0f			// 2^32, one period
+#define PHASE_PER_HZ	(PHASE_RANGE / CSampleRate::Get ())	// phase increment per sample and Hz
 
-float COscillator::s_SineTable[SINE_POINTS] =
-{
-0.00000000, 0.01745241, 0.03489950, 0.05233596, 0.06975647, 0.08715574, 0.10452846, 0.12186934,
-0.13917310, 0.15643447, 0.17364818, 0.19080900, 0.20791169, 0.22495105, 0.24192190, 0.25881905,
-0.27563736, 0.29237170, 0.30901699, 0.32556815, 0.34202014, 0.35836795, 0.37460659, 0.39073113,
-0.40673664, 0.42261826, 0.43837115, 0.45399050, 0.46947156, 0.48480962, 0.50000000, 0.51503807,
-0.52991926, 0.54463904, 0.55919290, 0.57357644, 0.58778525, 0.60181502, 0.61566148, 0.62932039,
-0.64278761, 0.65605903, 0.66913061, 0.68199836, 0.69465837, 0.70710678, 0.71933980, 0.73135370,
-0.74314483, 0.75470958, 0.76604444, 0.77714596, 0.78801075, 0.79863551, 0.80901699, 0.81915204,
-0.82903757, 0.83867057, 0.84804810, 0.85716730, 0.86602540, 0.87461971, 0.88294759, 0.89100652,
-0.89879405, 0.90630779, 0.91354546, 0.92050485, 0.92718385, 0.93358043, 0.93969262, 0.94551858,
-0.95105652, 0.95630476, 0.96126170, 0.96592583, 0.97029573, 0.97437006, 0.97814760, 0.98162718,
-0.98480775, 0.98768834, 0.99026807, 0.99254615, 0.99452190, 0.99619470, 0.99756405, 0.99862953,
-0.99939083, 0.99984770, 1.00000000, 0.99984770, 0.99939083, 0.99862953, 0.99756405, 0.99619470,
-0.99452190, 0.99254615, 0.99026807, 0.98768834, 0.98480775, 0.98162718, 0.97814760, 0.97437006,
-0.97029573, 0.96592583, 0.96126170, 0.95630476, 0.95105652, 0.94551858, 0.93969262, 0.93358043,
-0.92718385, 0.92050485, 0.91354546, 0.90630779, 0.89879405, 0.89100652, 0.88294759, 0.87461971,
-0.86602540, 0.85716730, 0.84804810, 0.83867057, 0.82903757, 0.81915204, 0.80901699, 0.79863551,
-0.78801075, 0.77714596, 0.76604444, 0.75470958, 0.74314483, 0.73135370, 0.71933980, 0.70710678,
-0.69465837, 0.68199836, 0.66913061, 0.65605903, 0.64278761, 0.62932039, 0.61566148, 0.60181502,
-0.58778525, 0.57357644, 0.55919290, 0.54463904, 0.52991926, 0.51503807, 0.50000000, 0.48480962,
-0.46947156, 0.45399050, 0.43837115, 0.42261826, 0.40673664, 0.39073113, 0.37460659, 0.35836795,
-0.34202014, 0.32556815, 0.30901699, 0.29237170, 0.27563736, 0.25881905, 0.24192190, 0.22495105,
-0.20791169, 0.19080900, 0.17364818, 0.15643447, 0.13917310, 0.12186934, 0.10452846, 0.08715574,
-0.06975647, 0.05233596, 0.03489950, 0.01745241, 0.00000000, -0.01745241, -0.03489950, -0.05233596,
--0.06975647, -0.08715574, -0.10452846, -0.12186934, -0.13917310, -0.15643447, -0.17364818, -0.19080900,
--0.20791169, -0.22495105, -0.24192190, -0.25881905, -0.27563736, -0.29237170, -0.30901699, -0.32556815,
--0.34202014, -0.35836795, -0.37460659, -0.39073113, -0.40673664, -0.42261826, -0.43837115, -0.45399050,
--0.46947156, -0.48480962, -0.50000000, -0.51503807, -0.52991926, -0.54463904, -0.55919290, -0.57357644,
--0.58778525, -0.60181502, -0.61566148, -0.62932039, -0.64278761, -0.65605903, -0.66913061, -0.68199836,
--0.69465837, -0.70710678, -0.71933980, -0.73135370, -0.74314483, -0.75470958, -0.76604444, -0.77714596,
--0.78801075, -0.79863551, -0.80901699, -0.81915204, -0.82903757, -0.83867057, -0.84804810, -0.85716730,
--0.86602540, -0.87461971, -0.88294759, -0.89100652, -0.89879405, -0.90630779, -0.91354546, -0.92050485,
--0.92718385, -0.93358043, -0.93969262, -0.94551858, -0.95105652, -0.95630476, -0.96126170, -0.96592583,
--0.97029573, -0.97437006, -0.97814760, -0.98162718, -0.98480775, -0.98768834, -0.99026807, -0.99254615,
--0.99452190, -0.99619470, -0.99756405, -0.99862953, -0.99939083, -0.99984770, -1.00000000, -0.99984770,
--0.99939083, -0.99862953, -0.99756405, -0.99619470, -0.99452190, -0.99254615, -0.99026807, -0.98768834,
--0.98480775, -0.98162718, -0.97814760, -0.97437006, -0.97029573, -0.96592583, -0.96126170, -0.95630476,
--0.95105652, -0.94551858, -0.93969262, -0.93358043, -0.92718385, -0.92050485, -0.91354546, -0.90630779,
--0.89879405, -0.89100652, -0.88294759, -0.87461971, -0.86602540, -0.85716730, -0.84804810, -0.83867057,
--0.82903757, -0.81915204, -0.80901699, -0.79863551, -0.78801075, -0.77714596, -0.76604444, -0.75470958,
--0.74314483, -0.73135370, -0.71933980, -0.70710678, -0.69465837, -0.68199836, -0.66913061, -0.65605903,
--0.64278761, -0.62932039, -0.61566148, -0.60181502, -0.58778525, -0.57357644, -0.55919290, -0.54463904,
--0.52991926, -0.51503807, -0.50000000, -0.48480962, -0.46947156, -0.45399050, -0.43837115, -0.42261826,
--0.40673664, -0.39073113, -0.37460659, -0.35836795, -0.34202014, -0.32556815, -0.30901699, -0.29237170,
--0.27563736, -0.25881905, -0.24192190, -0.22495105, -0.20791169, -0.19080900, -0.17364818, -0.15643447,
--0.13917310, -0.12186934, -0.10452846, -0.08715574, -0.06975647, -0.05233596, -0.03489950, -0.01745241
-};
-
-COscillator::COscillator (CSynthModule *pModulator)
-:	m_pModulator (pModulator),
-	m_Waveform (WaveformSine),
-	m_fFrequency (20.0),
-	m_fMidFrequency (m_fFrequency),
-	m_fDetune (0.0),
-	m_fModulationVolume (0.0),
-	m_nSampleCount (0),
-	m_fOutputLevel (0.0),
-	m_nRandSeed (1)
+#define MODULATION_RANGE	20.0f			// in Hz at modulation volume 1.0
+
+CWaveTable COscillator::s_WaveTable;
+
+COscillator::COscillator (boolean bControlRate)
+:	m_bControlRate (bControlRate),
+	m_pParameters (0)
 {
+	for (unsigned i = 0; i < VOICE_LANES; i++)
+	{
+		m_nPhase[i] = 0;
+		m_fFrequencyIncrement[i] = PHASE_PER_HZ;
+		m_fOutputLevel[i] = 0.0;
+		m_nRandSeed[i] = 1;
+	}
 }
 
 COscillator::~COscillator (void)
 {
-	m_pModulator = 0;
+	m_pParameters = 0;
 }
 
-void COscillator::SetWaveform (TWaveform Waveform)
+void COscillator::SetParameters (const TOscillatorParameters *pParameters)
 {
-	assert (Waveform < WaveformUnknown);
-	m_Waveform = Waveform;
+	assert (pParameters != 0);
+	assert (pParameters->Waveform < WaveformUnknown);
+	m_pParameters = pParameters;
 }
 
-void COscillator::SetFrequency (float fFrequency)
+void COscillator::SetFrequency (unsigned nVoice, float fFrequency)
 {
+	assert (nVoice < VOICES_PER_CORE);
 	assert (fFrequency > 0.0);
-	m_fMidFrequency = fFrequency;
-	m_fFrequency = exp2f (log2f (m_fMidFrequency) + m_fDetune);
+	m_fFrequencyIncrement[nVoice] = fFrequency * PHASE_PER_HZ;
 }
 
-void COscillator::SetDetune (float fDetune)
+void COscillator::CompileParameters (TWaveform Waveform, float fFrequencyFactor, float fDetune,
+				     float fModulationVolume, TOscillatorParameters *pResult)
 {
+	assert (Waveform < WaveformUnknown);
+	assert (fFrequencyFactor > 0.0);
 	assert (-1.0 <= fDetune && fDetune <= 1.0);
-	m_fDetune = fDetune / 12.0;
-	m_fFrequency = exp2f (log2f (m_fMidFrequency) + m_fDetune);
-}
+	assert (0.0 <= fModulationVolume && fModulationVolume <= 1.0);
+	assert (pResult != 0);
 
-void COscillator::SetModulationVolume (float fVolume)
-{
-	assert (0.0 <= fVolume && fVolume <= 1.0);
-	m_fModulationVolume = fVolume;
+	pResult->Waveform = Waveform;
+	pResult->fFrequencyFactor = fFrequencyFactor * exp2f (fDetune / 12.0f);
+	pResult->fModulationIncrement = fModulationVolume * MODULATION_RANGE * PHASE_PER_HZ;
 }
 
-void COscillator::NextSample (void)
+void COscillator::RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames,
+			       const float *pModulation)
 {
-	float fFrequency = m_fFrequency;
-	if (m_pModulator != 0)
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+
+	const TOscillatorParameters *pParameters = m_pParameters;
+	assert (pParameters != 0);
+
+	if (pParameters->Waveform == WaveformWhiteNoise)
+	{
+		RenderNoise (nGroup, pBuffer, nFrames);
+
+		return;
+	}
+
+	if (m_bControlRate)
 	{
-		fFrequency += m_pModulator->GetOutputLevel () * m_fModulationVolume * 20.0;
-		if (fFrequency <= 0.0)
+		assert (pModulation == 0);
+		RenderControlRate (nGroup, pBuffer, nFrames);
+
+		return;
+	}
+
+	unsigned nFirst = nGroup * VECTOR_LANES;
+
+	// the increment is only re-calculated here if the frequency is modulated
+	float MidIncrement[VECTOR_LANES];
+	u32 TableOffset[VECTOR_LANES];		// from the table of level 0
+	const float *pBase = s_WaveTable.GetTable (pParameters->Waveform, 0);
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
+	{
+		MidIncrement[l] = m_fFrequencyIncrement[nFirst + l] * pParameters->fFrequencyFactor;
+
+		// select the table by the highest possible frequency in this block
+		float fMaxIncrement = MidIncrement[l];
+		if (pModulation != 0)
 		{
-			return;
+			fMaxIncrement += pParameters->fModulationIncrement;
 		}
+
+		const float *pTable = s_WaveTable.GetTable (pParameters->Waveform,
+				CWaveTable::GetLevel (  fMaxIncrement < PHASE_RANGE/2
+						      ? (u32) fMaxIncrement : 0x80000000U));
+		TableOffset[l] = (u32) (pTable - pBase);
 	}
 
-	unsigned nPeriod = SAMPLE_RATE / fFrequency + 0.5;
-	if (++m_nSampleCount >= nPeriod)
+	TVector MidIncrementV = VectorLoad (MidIncrement);
+	TVector ModulationIncrement = VectorSet (pParameters->fModulationIncrement);
+	TVectorInt PhaseIncrement = VectorToInt (MidIncrementV);
+	TVectorInt TableOffsetV = VectorLoadInt (TableOffset);
+
+	TVectorInt Phase = VectorLoadInt (&m_nPhase[nFirst]);
+	TVector OutputLevel = VectorLoad (&m_fOutputLevel[nFirst]);
+
+	const TVectorInt FractionMask = VectorSetInt ((1U << (32-WAVETABLE_SIZE_BITS))-1);
+	const TVector FractionScale = VectorSet (1.0f / (1U << (32-WAVETABLE_SIZE_BITS)));
+
+	for (unsigned i = 0; i < nFrames; i++)
 	{
-		m_nSampleCount = 0;
+		// a voice holds its level, while its modulated frequency is not positive
+		TVectorInt Running = VectorSetInt (0xFFFFFFFFU);
+		if (pModulation != 0)
+		{
+			TVector Increment = VectorAdd (MidIncrementV,
+						       VectorMul (VectorLoad (&pModulation[i * VECTOR_LANES]),
+								  ModulationIncrement));
+			Running = VectorGreater (Increment, VectorSet (0.0f));
+			PhaseIncrement = VectorToInt (VectorMax (Increment, VectorSet (0.0f)));
+		}
+
+		Phase = VectorAddInt (Phase, PhaseIncrement);
+
+		// CWaveTable::GetSample() for all lanes
+		TVectorInt Index = VectorAddInt (TableOffsetV,
+						 VectorShiftRightInt (Phase, 32-WAVETABLE_SIZE_BITS));
+		TVector Fraction = VectorMul (VectorFromInt (VectorAndInt (Phase, FractionMask)),
+					      FractionScale);
+
+		TVector Level0 = VectorGather (pBase, Index);
+		TVector Level1 = VectorGather (pBase + 1, Index);
+		TVector Level = VectorAdd (Level0, VectorMul (Fraction, VectorSub (Level1, Level0)));
+
+		OutputLevel = VectorSelect (Running, Level, OutputLevel);
+
+		VectorStore (&pBuffer[i * VECTOR_LANES], OutputLevel);
 	}
 
-	switch (m_Waveform)
+	VectorStoreInt (&m_nPhase[nFirst], Phase);
+	VectorStore (&m_fOutputLevel[nFirst], OutputLevel);
+}
+
+void COscillator::RenderControlRate (unsigned nGroup, float *pBuffer, unsigned nFrames)
+{
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+
+	const TOscillatorParameters *pParameters = m_pParameters;
+	assert (pParameters != 0);
+
+	unsigned nFirst = nGroup * VECTOR_LANES;
+
+	u32 PhaseIncrement[VECTOR_LANES];
+	const float *pTable[VECTOR_LANES];
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
 	{
-	case WaveformSine:
-		m_fOutputLevel = s_SineTable[m_nSampleCount * SINE_POINTS / nPeriod];
-		break;
-
-	case WaveformSquare:
-		m_fOutputLevel = m_nSampleCount*2 < nPeriod ? 1.0 : -1.0;
-		break;
-
-	case WaveformSawtooth:
-		m_fOutputLevel = -1.0 + (2.0 * m_nSampleCount) / nPeriod;
-		break;
-
-	case WaveformTriangle:
-		m_fOutputLevel =   m_nSampleCount*2 < nPeriod
-				 ? -1.0 + (2.0 * m_nSampleCount*2) / nPeriod
-				 : 1.0 - (2.0 * (m_nSampleCount*2-nPeriod)) / nPeriod;
-		break;
-
-	case WaveformPulse12:
-	case WaveformPulse25: {
-		float fPulseWidth = m_Waveform == WaveformPulse12 ? 0.125 : 0.25;
-		m_fOutputLevel = m_nSampleCount < nPeriod*fPulseWidth ? 1.0 : -1.0;
-		} break;
-
-	case WaveformWhiteNoise:
-		m_fOutputLevel = rand_r (&m_nRandSeed) * (2.0 / RAND_MAX) - 1.0;
-		break;
-
-	default:
-		assert (0);
-		break;
+		PhaseIncrement[l] = (u32) (  m_fFrequencyIncrement[nFirst + l]
+					   * pParameters->fFrequencyFactor);
+
+		pTable[l] = s_WaveTable.GetTable (pParameters->Waveform,
+						  CWaveTable::GetLevel (PhaseIncrement[l]));
+	}
+
+	TVector OutputLevel = VectorLoad (&m_fOutputLevel[nFirst]);
+	CControlRate ControlRate = m_ControlRate[nGroup];
+
+	for (unsigned i = 0; i < nFrames;)
+	{
+		float fReciprocal;
+		unsigned nPiece = ControlRate.NextPiece (nFrames - i, &fReciprocal);
+
+		float Target[VECTOR_LANES];
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
+		{
+			m_nPhase[nFirst + l] += PhaseIncrement[l] * nPiece;
+
+			Target[l] = CWaveTable::GetSample (pTable[l], m_nPhase[nFirst + l]);
+		}
+
+		TVector TargetV = VectorLoad (Target);
+		TVector Step = VectorMul (VectorSub (TargetV, OutputLevel), VectorSet (fReciprocal));
+		for (unsigned j = 1; j < nPiece; j++)
+		{
+			OutputLevel = VectorAdd (OutputLevel, Step);
+			VectorStore (&pBuffer[i++ * VECTOR_LANES], OutputLevel);
+		}
+
+		OutputLevel = TargetV;
+		VectorStore (&pBuffer[i++ * VECTOR_LANES], OutputLevel);
 	}
+
+	VectorStore (&m_fOutputLevel[nFirst], OutputLevel);
+	m_ControlRate[nGroup] = ControlRate;
 }
 
-float COscillator::GetOutputLevel (void) const
+void COscillator::RenderNoise (unsigned nGroup, float *pBuffer, unsigned nFrames)
 {
-	return m_fOutputLevel;
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+
+	unsigned nFirst = nGroup * VECTOR_LANES;
+
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
+	{
+		unsigned nRandSeed = m_nRandSeed[nFirst + l];
+		float fOutputLevel = m_fOutputLevel[nFirst + l];
+
+		for (unsigned i = 0; i < nFrames; i++)
+		{
+			fOutputLevel = synth_rand (&nRandSeed) * (2.0f / SYNTH_RAND_MAX) - 1.0f;
+
+			pBuffer[i * VECTOR_LANES + l] = fOutputLevel;
+		}
+
+		m_nRandSeed[nFirst + l] = nRandSeed;
+		m_fOutputLevel[nFirst + l] = fOutputLevel;
+	}
 }
@@ -4,7 +4,7 @@
 // General purpose oscillator
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,7 +22,10 @@
 #ifndef _oscillator_h
 #define _oscillator_h
 
-#include "synthmodule.h"
+#include "controlrate.h"
+#include "simd.h"
+#include "config.h"
+#include <circle/types.h>
 
 enum TWaveform
 {
@@ -36,36 +39,59 @@ enum TWaveform
 	WaveformUnknown
 };
 
-class COscillator : public CSynthModule
+struct TOscillatorParameters
+{
+	TWaveform Waveform;
+	float fFrequencyFactor;				// multiplies the frequency
+	float fModulationIncrement;			// per sample and modulator level
+};
+
+class CWaveTable;
+
+// Holds the oscillators of the VOICES_PER_CORE voices of a voice bank (nVoice is the
+// index in the bank). Each field of their state is stored in an array over the voices.
+// The voices are rendered in groups of VECTOR_LANES voices (nGroup), a block holds
+// the levels of all voices of the group for each frame.
+
+class COscillator
 {
 public:
-	COscillator (CSynthModule *pModulator = 0);
+	// an oscillator without modulation can work at control rate (as LFO)
+	COscillator (boolean bControlRate = FALSE);
 	~COscillator (void);
 
-	void SetWaveform (TWaveform Waveform);
-	void SetFrequency (float fFrequency);			// in Hz
-	void SetDetune (float fDetune);				// [-1.0, 1.0]
-	void SetModulationVolume (float fVolume);		// [0.0, 1.0]
+	// pParameters must stay valid, while the oscillators are rendered
+	void SetParameters (const TOscillatorParameters *pParameters);
 
-	void NextSample (void);
-	float GetOutputLevel (void) const;			// returns [-1.0, 1.0]
+	// the output frequency is fFrequency (default 1 Hz) multiplied with the
+	// frequency factor of the parameters, so that an LFO takes it from there
+	void SetFrequency (unsigned nVoice, float fFrequency);		// in Hz
 
-private:
-	CSynthModule *m_pModulator;
+	// pModulation is the output block of the modulator (0 for none)
+	void RenderBlock (unsigned nGroup, float *pBuffer, unsigned nFrames,
+			  const float *pModulation = 0);
+
+	// fDetune is [-1.0, 1.0] semitones, fModulationVolume is [0.0, 1.0]
+	static void CompileParameters (TWaveform Waveform, float fFrequencyFactor, float fDetune,
+				       float fModulationVolume, TOscillatorParameters *pResult);
 
-	TWaveform m_Waveform;
-	float m_fFrequency;
-	float m_fMidFrequency;
-	float m_fDetune;
-	float m_fModulationVolume;
+private:
+	void RenderControlRate (unsigned nGroup, float *pBuffer, unsigned nFrames);
+	void RenderNoise (unsigned nGroup, float *pBuffer, unsigned nFrames);
 
-	unsigned m_nSampleCount;
+private:
+	boolean m_bControlRate;
 
-	float m_fOutputLevel;
+	const TOscillatorParameters *m_pParameters;
 
-	unsigned m_nRandSeed;
+	// the phase is a fraction of the period in units of 1/2^32 and wraps around
+	u32 m_nPhase[VOICE_LANES];
+	float m_fFrequencyIncrement[VOICE_LANES];	// per sample at the set frequency
+	float m_fOutputLevel[VOICE_LANES];
+	unsigned m_nRandSeed[VOICE_LANES];
+	CControlRate m_ControlRate[VOICE_GROUPS];
 
-	static float s_SineTable[];
+	static CWaveTable s_WaveTable;
 };
 
 #endif
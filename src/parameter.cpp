@@ -2,7 +2,7 @@
 // parameter.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2022  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -113,6 +113,12 @@ const char *CParameter::GetString (void)
 		"Noise"
 	};
 
+	static const char *Curves[] =		// must match TEnvelopeCurve in envelopegenerator.h
+	{
+		"Linear",
+		"Exp."
+	};
+
 	switch (m_Type)
 	{
 	case ParameterWaveform:
@@ -143,6 +149,10 @@ const char *CParameter::GetString (void)
 		m_String.Format ("%u", m_nValue);
 		return m_String;
 
+	case ParameterCurve:
+		assert (m_nValue < sizeof Curves / sizeof Curves[0]);
+		return Curves[m_nValue];
+
 	default:
 		assert (0);
 		return "";
@@ -152,13 +162,15 @@ const char *CParameter::GetString (void)
 boolean CParameter::IsEditable (void) const
 {
 	return    m_Type != ParameterWaveform
-	       && m_Type != ParameterChannel;
+	       && m_Type != ParameterChannel
+	       && m_Type != ParameterCurve;
 }
 
 const char *CParameter::GetEditString (void)
 {
 	assert (   m_Type != ParameterWaveform
-		&& m_Type != ParameterChannel);
+		&& m_Type != ParameterChannel
+		&& m_Type != ParameterCurve);
 	if (m_Type != ParameterFrequencyTenth)
 	{
 		m_String.Format ("%u", m_nValue);
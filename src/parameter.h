@@ -4,7 +4,7 @@
 // One parameter of a patch
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2022  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -33,6 +33,7 @@ enum TParameterType
 	ParameterTime,
 	ParameterPercent,
 	ParameterChannel,
+	ParameterCurve,
 	ParameterTypeUnknown
 };
 
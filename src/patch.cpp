@@ -2,7 +2,7 @@
 // patch.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2022  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -19,6 +19,7 @@
 //
 #include "patch.h"
 #include "oscillator.h"
+#include "envelopegenerator.h"
 #include <assert.h>
 
 static const struct
@@ -52,6 +53,7 @@ ParameterList[] =		// must match TSynthParameter
 	{"EGVCFDecay", ParameterTime, 100, 10000, 100, 4000, "Decay"},
 	{"EGVCFSustain", ParameterPercent, 0, 100, 10, 100, "Sustain"},
 	{"EGVCFRelease", ParameterTime, 0, 5000, 100, 1000, "Release"},
+	{"EGVCFCurve", ParameterCurve, EnvelopeCurveLinear, EnvelopeCurveExponential, 1, EnvelopeCurveLinear, "Curve"},
 
 	{"VCFModulationVolume", ParameterPercent, 0, 100, 5, 0, "Volume"},
 
@@ -63,6 +65,7 @@ ParameterList[] =		// must match TSynthParameter
 	{"EGVCADecay", ParameterTime, 100, 10000, 100, 4000, "Decay"},
 	{"EGVCASustain", ParameterPercent, 0, 100, 10, 100, "Sustain"},
 	{"EGVCARelease", ParameterTime, 0, 5000, 100, 100, "Release"},
+	{"EGVCACurve", ParameterCurve, EnvelopeCurveLinear, EnvelopeCurveExponential, 1, EnvelopeCurveLinear, "Curve"},
 
 	{"VCAModulationVolume", ParameterPercent, 0, 100, 10, 0, "Volume"},
 
@@ -4,7 +4,7 @@
 // Container for patch settings, loadable from properties file
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2022  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -49,6 +49,7 @@ enum TSynthParameter			// the parameters of a patch
 	EGVCFDecay,
 	EGVCFSustain,
 	EGVCFRelease,
+	EGVCFCurve,
 
 	VCFModulationVolume,
 
@@ -60,6 +61,7 @@ enum TSynthParameter			// the parameters of a patch
 	EGVCADecay,
 	EGVCASustain,
 	EGVCARelease,
+	EGVCACurve,
 
 	VCAModulationVolume,
 
@@ -0,0 +1,213 @@
+//
+// patchcompiler.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "patchcompiler.h"
+#include "math.h"
+#include <assert.h>
+
+static_assert (SynthParameterUnknown <= 32, "a parameter mask has 32 bits only");
+
+CPatchCompiler::CPatchCompiler (void)
+:	m_pActive (0),
+	m_pPending (0)
+{
+}
+
+CPatchCompiler::~CPatchCompiler (void)
+{
+	m_pActive = 0;
+	m_pPending = 0;
+}
+
+void CPatchCompiler::Publish (const CPatch *pPatch)
+{
+	assert (pPatch != 0);
+
+	// the buffer, which is neither active nor pending, is free
+	TCompiledPatch *pFree = 0;
+	for (unsigned i = 0; i < sizeof m_Buffer / sizeof m_Buffer[0]; i++)
+	{
+		if (   &m_Buffer[i] != m_pActive
+		    && &m_Buffer[i] != m_pPending)
+		{
+			pFree = &m_Buffer[i];
+
+			break;
+		}
+	}
+
+	assert (pFree != 0);
+	Compile (pPatch, pFree);
+
+	m_pPending = pFree;
+}
+
+const TCompiledPatch *CPatchCompiler::PickUp (void)
+{
+	TCompiledPatch *pPending = m_pPending;
+	if (pPending != 0)
+	{
+		m_pActive = pPending;
+		m_pPending = 0;
+	}
+
+	return pPending;
+}
+
+const TCompiledPatch *CPatchCompiler::Update (const CPatch *pPatch, u32 nParameterMask)
+{
+	assert (pPatch != 0);
+
+	static const TModule ModuleOf[/* TSynthParameter */] =
+	{
+		ModuleLFO_VCO,	ModuleLFO_VCO,				// LFOVCO*
+		ModuleVCO,	ModuleVCO,	ModuleVCO,		// VCO*
+		ModuleLFO_VCF,	ModuleLFO_VCF,				// LFOVCF*
+		ModuleVCF,	ModuleVCF,				// VCFCutoffFrequency, VCFResonance
+		ModuleEG_VCF,	ModuleEG_VCF,	ModuleEG_VCF,	ModuleEG_VCF,	ModuleEG_VCF,	// EGVCF*
+		ModuleVCF,						// VCFModulationVolume
+		ModuleLFO_VCA,	ModuleLFO_VCA,				// LFOVCA*
+		ModuleEG_VCA,	ModuleEG_VCA,	ModuleEG_VCA,	ModuleEG_VCA,	ModuleEG_VCA,	// EGVCA*
+		ModuleVCA,						// VCAModulationVolume
+		ModuleReverb,	ModuleReverb,				// Reverb*
+		ModuleSynth,						// SynthVolume
+		ModuleUnknown						// MIDIChannel
+	};
+	static_assert (sizeof ModuleOf / sizeof ModuleOf[0] == SynthParameterUnknown,
+		       "ModuleOf[] does not match TSynthParameter");
+
+	if (m_pActive == 0)
+	{
+		return 0;
+	}
+
+	// each affected module is compiled once only
+	unsigned nModuleMask = 0;
+	for (unsigned i = 0; i < SynthParameterUnknown; i++)
+	{
+		if (nParameterMask & (1U << i))
+		{
+			nModuleMask |= 1U << ModuleOf[i];
+		}
+	}
+
+	for (unsigned i = 0; i < ModuleUnknown; i++)
+	{
+		if (nModuleMask & (1U << i))
+		{
+			CompileModule (pPatch, (TModule) i, m_pActive);
+		}
+	}
+
+	return m_pActive;
+}
+
+void CPatchCompiler::Compile (const CPatch *pPatch, TCompiledPatch *pResult)
+{
+	for (unsigned i = 0; i < ModuleUnknown; i++)
+	{
+		CompileModule (pPatch, (TModule) i, pResult);
+	}
+}
+
+void CPatchCompiler::CompileModule (const CPatch *pPatch, TModule Module, TCompiledPatch *pResult)
+{
+	assert (pPatch != 0);
+	assert (pResult != 0);
+
+	switch (Module)
+	{
+	// VCO
+	case ModuleLFO_VCO:
+		COscillator::CompileParameters ((TWaveform) pPatch->GetParameter (LFOVCOWaveform),
+						pPatch->GetParameter (LFOVCOFrequency),
+						0.0f, 0.0f, &pResult->LFO_VCO);
+		break;
+
+	case ModuleVCO:
+		COscillator::CompileParameters ((TWaveform) pPatch->GetParameter (VCOWaveform), 1.0f,
+						0.0f, pPatch->GetParameter (VCOModulationVolume) / 100.0,
+						&pResult->VCO);
+
+		COscillator::CompileParameters ((TWaveform) pPatch->GetParameter (VCOWaveform), 1.0f,
+						pPatch->GetParameter (VCODetune) / 100.0 - 1.0,
+						pPatch->GetParameter (VCOModulationVolume) / 100.0,
+						&pResult->VCO2);
+		break;
+
+	// VCF
+	case ModuleLFO_VCF:
+		COscillator::CompileParameters ((TWaveform) pPatch->GetParameter (LFOVCFWaveform),
+						pPatch->GetParameter (LFOVCFFrequency) / 10.0,
+						0.0f, 0.0f, &pResult->LFO_VCF);
+		break;
+
+	case ModuleEG_VCF:
+		CEnvelopeGenerator::CompileParameters (pPatch->GetParameter (EGVCFAttack),
+						       pPatch->GetParameter (EGVCFDecay),
+						       pPatch->GetParameter (EGVCFSustain) / 100.0,
+						       pPatch->GetParameter (EGVCFRelease),
+						       (TEnvelopeCurve) pPatch->GetParameter (EGVCFCurve),
+						       &pResult->EG_VCF);
+		break;
+
+	case ModuleVCF:
+		CFilter::CompileParameters (pPatch->GetParameter (VCFCutoffFrequency),
+					    pPatch->GetParameter (VCFResonance),
+					    pPatch->GetParameter (VCFModulationVolume) / 100.0,
+					    &pResult->VCF);
+		break;
+
+	// VCA
+	case ModuleLFO_VCA:
+		COscillator::CompileParameters ((TWaveform) pPatch->GetParameter (LFOVCAWaveform),
+						pPatch->GetParameter (LFOVCAFrequency) / 10.0,
+						0.0f, 0.0f, &pResult->LFO_VCA);
+		break;
+
+	case ModuleEG_VCA:
+		CEnvelopeGenerator::CompileParameters (pPatch->GetParameter (EGVCAAttack),
+						       pPatch->GetParameter (EGVCADecay),
+						       pPatch->GetParameter (EGVCASustain) / 100.0,
+						       pPatch->GetParameter (EGVCARelease),
+						       (TEnvelopeCurve) pPatch->GetParameter (EGVCACurve),
+						       &pResult->EG_VCA);
+		break;
+
+	case ModuleVCA:
+		pResult->VCA.fModulationVolume = pPatch->GetParameter (VCAModulationVolume) / 100.0;
+		break;
+
+	// Effects
+	case ModuleReverb:
+		CReverbModule::CompileParameters (pPatch->GetParameter (ReverbDecay) / 100.0f,
+						  pPatch->GetParameter (ReverbVolume) / 100.0f,
+						  &pResult->Reverb);
+		break;
+
+	// Synth
+	case ModuleSynth:
+		pResult->fVolume = powf (pPatch->GetParameter (SynthVolume) / 100.0, 3.3f); // apply some curve
+		break;
+
+	default:
+		assert (0);
+		break;
+	}
+}
@@ -0,0 +1,113 @@
+//
+// patchcompiler.h
+//
+// Compiles a patch into the parameters used by the renderer
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _patchcompiler_h
+#define _patchcompiler_h
+
+#include "patch.h"
+#include "oscillator.h"
+#include "envelopegenerator.h"
+#include "filter.h"
+#include "amplifier.h"
+#include "reverbmodule.h"
+#include <circle/types.h>
+
+struct TCompiledPatch			// all values are pre-calculated
+{
+	// VCO
+	TOscillatorParameters LFO_VCO;
+	TOscillatorParameters VCO;
+	TOscillatorParameters VCO2;
+
+	// VCF
+	TOscillatorParameters LFO_VCF;
+	TEnvelopeParameters EG_VCF;
+	TFilterParameters VCF;
+
+	// VCA
+	TOscillatorParameters LFO_VCA;
+	TEnvelopeParameters EG_VCA;
+	TAmplifierParameters VCA;
+
+	// Effects
+	TReverbParameters Reverb;
+
+	// Synth
+	float fVolume;
+};
+
+// The voices read their parameters directly from the compiled patch, which is
+// used by the renderer (the active one). Therefore a patch is compiled into
+// another buffer and published as pending. The renderer picks it up at the
+// next block, which only swaps a pointer. There are three buffers: the active,
+// the pending and the free one, which the next patch is compiled into. A patch,
+// which is published, while another one is still pending, replaces it.
+// Publish() and PickUp() have to be serialized by the caller.
+//
+// Single parameters (e.g. from MIDI CC) are updated by the renderer itself in
+// the active buffer with Update(), which Publish() does not touch. Only the
+// parameters of the affected modules are compiled.
+
+class CPatchCompiler
+{
+public:
+	CPatchCompiler (void);
+	~CPatchCompiler (void);
+
+	// compiles pPatch and publishes it as pending
+	void Publish (const CPatch *pPatch);
+
+	// returns the pending compiled patch, which is active from now on, or 0
+	const TCompiledPatch *PickUp (void);
+
+	// re-compiles the modules, which depend on the parameters in nParameterMask
+	// (bit 1 << TSynthParameter), in the active compiled patch from pPatch,
+	// returns the active compiled patch or 0, if there is none
+	const TCompiledPatch *Update (const CPatch *pPatch, u32 nParameterMask);
+
+	static void Compile (const CPatch *pPatch, TCompiledPatch *pResult);
+
+private:
+	enum TModule
+	{
+		ModuleLFO_VCO,
+		ModuleVCO,				// VCO and VCO2
+		ModuleLFO_VCF,
+		ModuleEG_VCF,
+		ModuleVCF,
+		ModuleLFO_VCA,
+		ModuleEG_VCA,
+		ModuleVCA,
+		ModuleReverb,
+		ModuleSynth,
+		ModuleUnknown
+	};
+
+	static void CompileModule (const CPatch *pPatch, TModule Module, TCompiledPatch *pResult);
+
+private:
+	TCompiledPatch m_Buffer[3];
+
+	TCompiledPatch *m_pActive;
+	TCompiledPatch *m_pPending;
+};
+
+#endif
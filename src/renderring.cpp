@@ -0,0 +1,129 @@
+//
+// renderring.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "renderring.h"
+#include "coresync.h"
+#include <assert.h>
+
+CRenderRing::CRenderRing (void)
+:	m_nWriteIndex (0),
+	m_nReadIndex (0)
+{
+}
+
+CRenderRing::~CRenderRing (void)
+{
+}
+
+unsigned CRenderRing::GetFree (void) const
+{
+	u32 nReadIndex = __atomic_load_n (&m_nReadIndex, __ATOMIC_ACQUIRE);
+
+	return RENDER_RING_FRAMES - (m_nWriteIndex - nReadIndex);
+}
+
+void CRenderRing::Write (const float *pLeft, const float *pRight, unsigned nFrames, float fVolume)
+{
+	assert (pLeft != 0);
+	assert (pRight != 0);
+	assert (nFrames <= GetFree ());
+
+	u32 nWriteIndex = m_nWriteIndex;
+	while (nFrames > 0)
+	{
+		// up to the end of the buffer
+		unsigned nPos = nWriteIndex & (RENDER_RING_FRAMES-1);
+		unsigned nPiece = RENDER_RING_FRAMES - nPos;
+		if (nPiece > nFrames)
+		{
+			nPiece = nFrames;
+		}
+
+		float *pRingLeft = &m_Left[nPos];
+		float *pRingRight = &m_Right[nPos];
+		for (unsigned i = 0; i < nPiece; i++)
+		{
+			pRingLeft[i] = pLeft[i] * fVolume;
+			pRingRight[i] = pRight[i] * fVolume;
+		}
+
+		pLeft += nPiece;
+		pRight += nPiece;
+		nWriteIndex += nPiece;
+		nFrames -= nPiece;
+	}
+
+	// publish the frames, after they have been written
+	__atomic_store_n (&m_nWriteIndex, nWriteIndex, __ATOMIC_RELEASE);
+	CCoreSync::SendEvent ();
+}
+
+void CRenderRing::WriteSilence (unsigned nFrames)
+{
+	assert (nFrames <= GetFree ());
+
+	u32 nWriteIndex = m_nWriteIndex;
+	for (unsigned i = 0; i < nFrames; i++)
+	{
+		unsigned nPos = nWriteIndex++ & (RENDER_RING_FRAMES-1);
+
+		m_Left[nPos] = 0.0f;
+		m_Right[nPos] = 0.0f;
+	}
+
+	__atomic_store_n (&m_nWriteIndex, nWriteIndex, __ATOMIC_RELEASE);
+	CCoreSync::SendEvent ();
+}
+
+unsigned CRenderRing::GetFilled (void) const
+{
+	return __atomic_load_n (&m_nWriteIndex, __ATOMIC_ACQUIRE) - m_nReadIndex;
+}
+
+unsigned CRenderRing::Peek (const float **ppLeft, const float **ppRight, unsigned nMaxFrames) const
+{
+	assert (ppLeft != 0);
+	assert (ppRight != 0);
+
+	unsigned nFrames = GetFilled ();
+	if (nFrames > nMaxFrames)
+	{
+		nFrames = nMaxFrames;
+	}
+
+	unsigned nPos = m_nReadIndex & (RENDER_RING_FRAMES-1);
+	if (nFrames > RENDER_RING_FRAMES - nPos)
+	{
+		nFrames = RENDER_RING_FRAMES - nPos;
+	}
+
+	*ppLeft = &m_Left[nPos];
+	*ppRight = &m_Right[nPos];
+
+	return nFrames;
+}
+
+void CRenderRing::Consume (unsigned nFrames)
+{
+	assert (nFrames <= GetFilled ());
+
+	// free the frames, after they have been read
+	__atomic_store_n (&m_nReadIndex, m_nReadIndex + nFrames, __ATOMIC_RELEASE);
+	CCoreSync::SendEvent ();
+}
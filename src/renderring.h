@@ -0,0 +1,69 @@
+//
+// renderring.h
+//
+// Lock-free ring buffer, which passes rendered frames to the sound device
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _renderring_h
+#define _renderring_h
+
+#include <circle/types.h>
+#include "config.h"
+
+#if (RENDER_RING_FRAMES & (RENDER_RING_FRAMES-1)) != 0
+	#error RENDER_RING_FRAMES must be a power of 2
+#endif
+
+#if RENDER_RING_FRAMES < MAX_FRAMES_PER_CHUNK
+	#error RENDER_RING_FRAMES must hold a chunk
+#endif
+
+// Ring buffer of stereo frames for one producer (the renderer) and one consumer
+// (the output conversion), which may run on different cores. The indices run
+// freely like in CEventQueue. The consumer reads the frames in place with Peek()
+// and frees them with Consume() afterwards. Both sides send an event (see CCoreSync),
+// when they have moved their index, so that the other side can wait for it.
+
+class CRenderRing
+{
+public:
+	CRenderRing (void);
+	~CRenderRing (void);
+
+	// on the producer side
+	unsigned GetFree (void) const;
+	// nFrames <= GetFree(), the levels are multiplied with fVolume
+	void Write (const float *pLeft, const float *pRight, unsigned nFrames, float fVolume);
+	void WriteSilence (unsigned nFrames);			// nFrames <= GetFree()
+
+	// on the consumer side
+	unsigned GetFilled (void) const;
+	// returns the number of frames at the read position, which are continuous
+	// in memory (<= nMaxFrames, 0 if the ring is empty)
+	unsigned Peek (const float **ppLeft, const float **ppRight, unsigned nMaxFrames) const;
+	void Consume (unsigned nFrames);
+
+private:
+	float m_Left[RENDER_RING_FRAMES];
+	float m_Right[RENDER_RING_FRAMES];
+
+	u32 m_nWriteIndex;				// written by the producer only
+	u32 m_nReadIndex;				// written by the consumer only
+};
+
+#endif
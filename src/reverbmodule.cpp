@@ -5,7 +5,7 @@
 //	CCRMA, Stanford University, Stanford, CA, USA; 1997
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2020-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,6 +21,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "reverbmodule.h"
+#include "samplerate.h"
 #include <math.h>
 
 CReverbAttenuator::CReverbAttenuator (float fDamping)
@@ -37,9 +38,15 @@ void CReverbAttenuator::NextSample (float fInputLevel)
 	m_fMemory = fInputLevel;
 }
 
-CReverbDelay::CReverbDelay (unsigned nDelaySamples, CSynthModule *pLFO, unsigned nExcursion)
+void CReverbAttenuator::Clear (void)
+{
+	m_fMemory = 0.0f;
+	m_fOutputLevel = 0.0f;
+}
+
+CReverbDelay::CReverbDelay (unsigned nDelaySamples, const float *pLFOLevel, unsigned nExcursion)
 :	m_nDelaySamples (nDelaySamples),
-	m_pLFO (pLFO),
+	m_pLFOLevel (pLFOLevel),
 	m_nExcursion (nExcursion),
 	m_nSize (nDelaySamples+nExcursion+1),
 	m_pMemory (new float[m_nSize]),
@@ -60,9 +67,9 @@ CReverbDelay::~CReverbDelay (void)
 void CReverbDelay::NextSample (float fInputLevel)
 {
 	unsigned nDelay = m_nDelaySamples;
-	if (m_pLFO != 0)
+	if (m_pLFOLevel != 0)
 	{
-		nDelay += m_pLFO->GetOutputLevel ()*m_nExcursion;
+		nDelay += *m_pLFOLevel*m_nExcursion;
 	}
 
 	unsigned nOutPtr = m_nInPtr-nDelay;
@@ -80,10 +87,20 @@ void CReverbDelay::NextSample (float fInputLevel)
 	}
 }
 
+void CReverbDelay::Clear (void)
+{
+	for (unsigned i = 0; i < m_nSize; i++)
+	{
+		m_pMemory[i] = 0.0f;
+	}
+
+	m_fOutputLevel = 0.0f;
+}
+
 CReverbDiffuser::CReverbDiffuser (float fDiffusion, unsigned nDelaySamples,
-				  CSynthModule *pLFO, unsigned nExcursion)
+				  const float *pLFOLevel, unsigned nExcursion)
 :	m_fDiffusion (fDiffusion),
-	m_Delay (nDelaySamples, pLFO, nExcursion),
+	m_Delay (nDelaySamples, pLFOLevel, nExcursion),
 	m_fOutputLevel (0.0f)
 {
 }
@@ -102,67 +119,176 @@ void CReverbDiffuser::NextSample (float fInputLevel)
 	m_fOutputLevel = fTemp*m_fDiffusion + m_Delay.GetOutputLevel ();
 }
 
+void CReverbDiffuser::Clear (void)
+{
+	m_Delay.Clear ();
+
+	m_fOutputLevel = 0.0f;
+}
+
 CReverbModule::CReverbModule (void)
 :	m_fDecay (0.5f),
 	m_fDecayDiffusion2 (0.5f),
 	m_fWetDryRatio (0.25f),
 
+	m_fIdleLevel (powf (10.0f, REVERB_IDLE_DB / -20.0f)),
+	m_nQuietSamples (0),
+	m_bIdle (TRUE),
+	m_nTailSamples (CSampleRate::Scale (TailSamples)),
+
 	m_BandwidthAttenuator (1.0f-Bandwidth),
-	m_InputDiffuser13_14 (InputDiffusion1, 142),
-	m_InputDiffuser19_20 (InputDiffusion1, 107),
-	m_InputDiffuser15_16 (InputDiffusion2, 379),
-	m_InputDiffuser21_22 (InputDiffusion2, 277),
+	m_InputDiffuser13_14 (InputDiffusion1, CSampleRate::Scale (142)),
+	m_InputDiffuser19_20 (InputDiffusion1, CSampleRate::Scale (107)),
+	m_InputDiffuser15_16 (InputDiffusion2, CSampleRate::Scale (379)),
+	m_InputDiffuser21_22 (InputDiffusion2, CSampleRate::Scale (277)),
+
+	m_fLFOLevel23_24 (0.0f),
+	m_fLFOLevel46_48 (0.0f),
 
-	m_DecayDiffuser23_24 (-DecayDiffusion1, 672, &m_LFO23_24, Excursion),
-	m_Delay30 (4453),
+	m_DecayDiffuser23_24 (-DecayDiffusion1, CSampleRate::Scale (672),
+			     &m_fLFOLevel23_24, CSampleRate::Scale (Excursion)),
+	m_Delay30 (CSampleRate::Scale (4453)),
 	m_Attenuator30 (Damping),
-	m_DecayDiffuser31_33 (m_fDecayDiffusion2, 1800),
-	m_Delay39 (3720),
+	m_DecayDiffuser31_33 (m_fDecayDiffusion2, CSampleRate::Scale (1800)),
+	m_Delay39 (CSampleRate::Scale (3720)),
 
-	m_DecayDiffuser46_48 (-DecayDiffusion1, 908, &m_LFO46_48, Excursion),
-	m_Delay54 (4217),
+	m_DecayDiffuser46_48 (-DecayDiffusion1, CSampleRate::Scale (908),
+			     &m_fLFOLevel46_48, CSampleRate::Scale (Excursion)),
+	m_Delay54 (CSampleRate::Scale (4217)),
 	m_Attenuator54 (Damping),
-	m_DecayDiffuser55_59 (m_fDecayDiffusion2, 2656),
-	m_Delay63 (3163),
-
-	m_DelayL48_54_1 (266),
-	m_DelayL48_54_2 (2974),
-	m_DelayL55_59 (1913),
-	m_DelayL59_63 (1996),
-	m_DelayL24_30 (1990),
-	m_DelayL31_33 (187),
-	m_DelayL33_39 (1066),
+	m_DecayDiffuser55_59 (m_fDecayDiffusion2, CSampleRate::Scale (2656)),
+	m_Delay63 (CSampleRate::Scale (3163)),
+
+	m_DelayL48_54_1 (CSampleRate::Scale (266)),
+	m_DelayL48_54_2 (CSampleRate::Scale (2974)),
+	m_DelayL55_59 (CSampleRate::Scale (1913)),
+	m_DelayL59_63 (CSampleRate::Scale (1996)),
+	m_DelayL24_30 (CSampleRate::Scale (1990)),
+	m_DelayL31_33 (CSampleRate::Scale (187)),
+	m_DelayL33_39 (CSampleRate::Scale (1066)),
 	m_fOutputLevelLeft (0.0f),
 
-	m_DelayR24_30_1 (353),
-	m_DelayR24_30_2 (3627),
-	m_DelayR31_33 (1228),
-	m_DelayR33_39 (2673),
-	m_DelayR48_54 (2111),
-	m_DelayR55_59 (335),
-	m_DelayR59_63 (121),
+	m_DelayR24_30_1 (CSampleRate::Scale (353)),
+	m_DelayR24_30_2 (CSampleRate::Scale (3627)),
+	m_DelayR31_33 (CSampleRate::Scale (1228)),
+	m_DelayR33_39 (CSampleRate::Scale (2673)),
+	m_DelayR48_54 (CSampleRate::Scale (2111)),
+	m_DelayR55_59 (CSampleRate::Scale (335)),
+	m_DelayR59_63 (CSampleRate::Scale (121)),
 	m_fOutputLevelRight (0.0f)
 {
-	m_LFO23_24.SetWaveform (WaveformSine);
-	m_LFO23_24.SetFrequency (LFOFrequency23_24);
+	// both LFOs share the parameters and differ in the frequency only
+	COscillator::CompileParameters (WaveformSine, 1.0f, 0.0f, 0.0f, &m_LFOParameters);
+	m_LFO.SetParameters (&m_LFOParameters);
 
-	m_LFO46_48.SetWaveform (WaveformSine);
-	m_LFO46_48.SetFrequency (LFOFrequency46_48);
+	m_LFO.SetFrequency (LFO23_24, LFOFrequency23_24);
+	m_LFO.SetFrequency (LFO46_48, LFOFrequency46_48);
 }
 
-void CReverbModule::SetDecay (float fDecay)
+void CReverbModule::SetParameters (const TReverbParameters *pParameters)
 {
-	m_fDecay = fDecay;
-
-	m_fDecayDiffusion2 = ceilf (floorf ((m_fDecay + 0.15f) * 4.0f) / 2.0f) / 2.0f;
+	m_fDecay = pParameters->fDecay;
+	m_fDecayDiffusion2 = pParameters->fDecayDiffusion2;
+	m_fWetDryRatio = pParameters->fWetDryRatio;
 
 	m_DecayDiffuser31_33.SetDiffusion (m_fDecayDiffusion2);
 	m_DecayDiffuser55_59.SetDiffusion (m_fDecayDiffusion2);
 }
 
-void CReverbModule::SetWetDryRatio (float fWetDryRatio)
+void CReverbModule::CompileParameters (float fDecay, float fWetDryRatio,
+				       TReverbParameters *pResult)
+{
+	pResult->fDecay = fDecay;
+	pResult->fDecayDiffusion2 = ceilf (floorf ((fDecay + 0.15f) * 4.0f) / 2.0f) / 2.0f;
+	pResult->fWetDryRatio = fWetDryRatio;
+}
+
+void CReverbModule::RenderBlock (const float *pInput, float *pOutputLeft, float *pOutputRight,
+				 unsigned nFrames)
+{
+	float fPeak = 0.0f;
+
+	for (unsigned i = 0; i < nFrames;)
+	{
+		unsigned nBlockFrames = nFrames - i;
+		if (nBlockFrames > FRAMES_PER_BLOCK)
+		{
+			nBlockFrames = FRAMES_PER_BLOCK;
+		}
+
+		m_LFO.RenderBlock (0, m_LFOBlock, nBlockFrames);
+
+		for (unsigned j = 0; j < nBlockFrames; j++, i++)
+		{
+			m_fLFOLevel23_24 = m_LFOBlock[j * VECTOR_LANES + LFO23_24];
+			m_fLFOLevel46_48 = m_LFOBlock[j * VECTOR_LANES + LFO46_48];
+
+			NextSample (pInput[i]);
+
+			pOutputLeft[i] = m_fOutputLevelLeft;
+			pOutputRight[i] = m_fOutputLevelRight;
+
+			fPeak = fmaxf (fPeak, fabsf (pInput[i]));
+			fPeak = fmaxf (fPeak, fabsf (m_fOutputLevelLeft));
+			fPeak = fmaxf (fPeak, fabsf (m_fOutputLevelRight));
+		}
+	}
+
+	if (fPeak >= m_fIdleLevel)
+	{
+		m_nQuietSamples = 0;
+		m_bIdle = FALSE;
+	}
+	else if (!m_bIdle)
+	{
+		m_nQuietSamples += nFrames;
+		if (m_nQuietSamples >= m_nTailSamples)
+		{
+			// cut the rest of the tail
+			Clear ();
+
+			m_bIdle = TRUE;
+		}
+	}
+}
+
+void CReverbModule::Clear (void)
 {
-	m_fWetDryRatio = fWetDryRatio;
+	m_BandwidthAttenuator.Clear ();
+	m_InputDiffuser13_14.Clear ();
+	m_InputDiffuser19_20.Clear ();
+	m_InputDiffuser15_16.Clear ();
+	m_InputDiffuser21_22.Clear ();
+
+	m_DecayDiffuser23_24.Clear ();
+	m_Delay30.Clear ();
+	m_Attenuator30.Clear ();
+	m_DecayDiffuser31_33.Clear ();
+	m_Delay39.Clear ();
+
+	m_DecayDiffuser46_48.Clear ();
+	m_Delay54.Clear ();
+	m_Attenuator54.Clear ();
+	m_DecayDiffuser55_59.Clear ();
+	m_Delay63.Clear ();
+
+	m_DelayL48_54_1.Clear ();
+	m_DelayL48_54_2.Clear ();
+	m_DelayL55_59.Clear ();
+	m_DelayL59_63.Clear ();
+	m_DelayL24_30.Clear ();
+	m_DelayL31_33.Clear ();
+	m_DelayL33_39.Clear ();
+	m_fOutputLevelLeft = 0.0f;
+
+	m_DelayR24_30_1.Clear ();
+	m_DelayR24_30_2.Clear ();
+	m_DelayR31_33.Clear ();
+	m_DelayR33_39.Clear ();
+	m_DelayR48_54.Clear ();
+	m_DelayR55_59.Clear ();
+	m_DelayR59_63.Clear ();
+	m_fOutputLevelRight = 0.0f;
 }
 
 void CReverbModule::NextSample (float fInputLevel)
@@ -174,7 +300,6 @@ void CReverbModule::NextSample (float fInputLevel)
 	m_InputDiffuser15_16.NextSample (m_InputDiffuser19_20.GetOutputLevel ());
 	m_InputDiffuser21_22.NextSample (m_InputDiffuser15_16.GetOutputLevel ());
 
-	m_LFO23_24.NextSample ();
 	m_DecayDiffuser23_24.NextSample (  m_InputDiffuser21_22.GetOutputLevel ()
 					 + m_Delay63.GetOutputLevel ()*m_fDecay);
 	m_Delay30.NextSample (m_DecayDiffuser23_24.GetOutputLevel ());
@@ -182,7 +307,6 @@ void CReverbModule::NextSample (float fInputLevel)
 	m_DecayDiffuser31_33.NextSample (m_Attenuator30.GetOutputLevel ()*m_fDecay);
 	m_Delay39.NextSample (m_DecayDiffuser31_33.GetOutputLevel ());
 
-	m_LFO46_48.NextSample ();
 	m_DecayDiffuser46_48.NextSample (  m_InputDiffuser21_22.GetOutputLevel ()
 					 + m_Delay39.GetOutputLevel ()*m_fDecay);
 	m_Delay54.NextSample (m_DecayDiffuser46_48.GetOutputLevel ());
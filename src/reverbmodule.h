@@ -5,7 +5,7 @@
 //	CCRMA, Stanford University, Stanford, CA, USA; 1997
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2020-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,8 +23,9 @@
 #ifndef _reverbmodule_h
 #define _reverbmodule_h
 
-#include "synthmodule.h"
 #include "oscillator.h"
+#include "config.h"
+#include <circle/types.h>
 
 class CReverbAttenuator
 {
@@ -34,6 +35,8 @@ public:
 	void NextSample (float fInputLevel);
 	float GetOutputLevel (void) const	{ return m_fOutputLevel; }
 
+	void Clear (void);
+
 private:
 	float m_fDamping;
 
@@ -44,16 +47,19 @@ private:
 class CReverbDelay
 {
 public:
+	// the delay is modulated by the LFO level at pLFOLevel [-1.0, 1.0]
 	CReverbDelay (unsigned nDelaySamples,
-		      CSynthModule *pLFO = 0, unsigned nExcursion = 0);
+		      const float *pLFOLevel = 0, unsigned nExcursion = 0);
 	~CReverbDelay (void);
 
 	void NextSample (float fInputLevel);
 	float GetOutputLevel (void) const	{ return m_fOutputLevel; }
 
+	void Clear (void);
+
 private:
 	unsigned m_nDelaySamples;
-	CSynthModule *m_pLFO;
+	const float *m_pLFOLevel;
 	unsigned m_nExcursion;
 
 	unsigned m_nSize;
@@ -66,32 +72,54 @@ class CReverbDiffuser
 {
 public:
 	CReverbDiffuser (float fDiffusion, unsigned nDelaySamples,
-			 CSynthModule *pLFO = 0, unsigned nExcursion = 0);
+			 const float *pLFOLevel = 0, unsigned nExcursion = 0);
 
 	void SetDiffusion (float fDiffusion);
 
 	void NextSample (float fInputLevel);
 	float GetOutputLevel (void) const	{ return m_fOutputLevel; }
 
+	void Clear (void);
+
 private:
 	float m_fDiffusion;
 	CReverbDelay m_Delay;
 	float m_fOutputLevel;
 };
 
+struct TReverbParameters
+{
+	float fDecay;
+	float fDecayDiffusion2;
+	float fWetDryRatio;
+};
+
 class CReverbModule
 {
 public:
 	CReverbModule (void);
 
-	void SetDecay (float fDecay);
-	void SetWetDryRatio (float fWetDryRatio);
+	void SetParameters (const TReverbParameters *pParameters);	// copied
+
+	// fDecay and fWetDryRatio are [0.0, 1.0]
+	static void CompileParameters (float fDecay, float fWetDryRatio, TReverbParameters *pResult);
+
+	void RenderBlock (const float *pInput, float *pOutputLeft, float *pOutputRight,
+			  unsigned nFrames);
 
+	// the input and the output have been below -REVERB_IDLE_DB dBFS for longer than
+	// the tail needs to come out, the state has been cleared then, so that the output
+	// is silent, as long as the input is, and RenderBlock() can be skipped
+	boolean IsIdle (void) const		{ return m_bIdle; }
+
+private:
 	void NextSample (float fInputLevel);
-	float GetOutputLevelLeft (void) const	{ return m_fOutputLevelLeft; }
-	float GetOutputLevelRight (void) const	{ return m_fOutputLevelRight; }
+
+	void Clear (void);
 
 private:
+	// the sample counts here and in the constructor are given at
+	// SAMPLE_RATE_DEFAULT and scaled to the current sample rate
 	const unsigned Excursion = 16;
 	const float DecayDiffusion1 = 0.7f;
 	const float InputDiffusion1 = 0.75f;
@@ -101,25 +129,41 @@ private:
 	const float LFOFrequency23_24 = 0.5f;
 	const float LFOFrequency46_48 = 0.3f;
 
+	// longer than a round trip through the tank (21589 samples) and an output tap
+	const unsigned TailSamples = 32768;
+
+	// voices of m_LFO, which is rendered in blocks of one voice group
+	static const unsigned LFO23_24 = 0;
+	static const unsigned LFO46_48 = 1;
+
 private:
 	float m_fDecay;
 	float m_fDecayDiffusion2;
 	float m_fWetDryRatio;
 
+	float m_fIdleLevel;
+	unsigned m_nQuietSamples;			// input and output below m_fIdleLevel
+	boolean m_bIdle;
+	unsigned m_nTailSamples;			// at the current sample rate
+
 	CReverbAttenuator m_BandwidthAttenuator;
 	CReverbDiffuser m_InputDiffuser13_14;
 	CReverbDiffuser m_InputDiffuser19_20;
 	CReverbDiffuser m_InputDiffuser15_16;
 	CReverbDiffuser m_InputDiffuser21_22;
 
-	COscillator m_LFO23_24;
+	TOscillatorParameters m_LFOParameters;
+	COscillator m_LFO;
+	float m_LFOBlock[FRAMES_PER_BLOCK * VECTOR_LANES];
+	float m_fLFOLevel23_24;
+	float m_fLFOLevel46_48;
+
 	CReverbDiffuser m_DecayDiffuser23_24;
 	CReverbDelay m_Delay30;
 	CReverbAttenuator m_Attenuator30;
 	CReverbDiffuser m_DecayDiffuser31_33;
 	CReverbDelay m_Delay39;
 
-	COscillator m_LFO46_48;
 	CReverbDiffuser m_DecayDiffuser46_48;
 	CReverbDelay m_Delay54;
 	CReverbAttenuator m_Attenuator54;
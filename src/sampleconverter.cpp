@@ -0,0 +1,281 @@
+//
+// sampleconverter.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "sampleconverter.h"
+#include "simd.h"
+#include "config.h"
+#include <circle/util.h>
+#include <assert.h>
+
+// clamping before the truncation gives the same result as afterwards,
+// because the limits are integers
+static inline TVectorInt ConvertVector (TVector Level, TVector Scale, TVector Null,
+					TVector Min, TVector Max)
+{
+	Level = VectorAdd (VectorMul (Level, Scale), Null);
+
+	return VectorToSignedInt (VectorMin (VectorMax (Level, Min), Max));
+}
+
+CSampleConverter::CSampleConverter (TSampleFormat Format, float fScale, int nNullLevel,
+				    int nMinLevel, int nMaxLevel, boolean bChannelsSwapped)
+:	m_Format (Format),
+	m_fScale (fScale),
+	m_fNullLevel ((float) nNullLevel),
+	m_fMinLevel ((float) nMinLevel),
+	m_fMaxLevel ((float) nMaxLevel),
+	m_bChannelsSwapped (bChannelsSwapped)
+{
+	assert (Format < SampleFormatUnknown);
+	assert (nMinLevel < nMaxLevel);
+}
+
+CSampleConverter::~CSampleConverter (void)
+{
+}
+
+unsigned CSampleConverter::GetSampleSize (void) const
+{
+	switch (m_Format)
+	{
+	case SampleFormatInt32:
+		return sizeof (u32);
+
+	case SampleFormatInt16:
+		return sizeof (s16);
+
+	case SampleFormatInt24Packed:
+		return 3;
+
+	default:
+		assert (0);
+		return 0;
+	}
+}
+
+void *CSampleConverter::Convert (const float *pLeft, const float *pRight, unsigned nFrames,
+				 void *pBuffer, unsigned nChannels) const
+{
+	assert (pLeft != 0);
+	assert (pRight != 0);
+	assert (pBuffer != 0);
+	assert (nChannels >= 2);
+
+	const float *pFirst = pLeft;
+	const float *pSecond = pRight;
+	if (m_bChannelsSwapped)
+	{
+		pFirst = pRight;
+		pSecond = pLeft;
+	}
+
+	// the common cases are interleaved directly
+	if (nChannels == 2)
+	{
+		if (m_Format == SampleFormatInt32)
+		{
+			ConvertInterleaved (pFirst, pSecond, nFrames, pBuffer);
+
+			return (u32 *) pBuffer + nFrames*2;
+		}
+
+		if (m_Format == SampleFormatInt16)
+		{
+			ConvertInterleaved (pFirst, pSecond, nFrames, pBuffer);
+
+			return (s16 *) pBuffer + nFrames*2;
+		}
+	}
+
+	u8 *pOutput = (u8 *) pBuffer;
+	while (nFrames > 0)
+	{
+		unsigned nPiece = nFrames;
+		if (nPiece > FRAMES_PER_BLOCK)
+		{
+			nPiece = FRAMES_PER_BLOCK;
+		}
+
+		u32 First[FRAMES_PER_BLOCK];
+		u32 Second[FRAMES_PER_BLOCK];
+		ConvertLevels (pFirst, First, nPiece);
+		ConvertLevels (pSecond, Second, nPiece);
+
+		// the further channels are zero
+		if (nChannels > 2)
+		{
+			memset (pOutput, 0, nPiece * nChannels * GetSampleSize ());
+		}
+
+		if (m_Format == SampleFormatInt32)
+		{
+			u32 *p = (u32 *) pOutput;
+			for (unsigned i = 0; i < nPiece; i++)
+			{
+				p[0] = First[i];
+				p[1] = Second[i];
+
+				p += nChannels;
+			}
+
+			pOutput = (u8 *) p;
+		}
+		else if (m_Format == SampleFormatInt16)
+		{
+			s16 *p = (s16 *) pOutput;
+			for (unsigned i = 0; i < nPiece; i++)
+			{
+				p[0] = (s16) First[i];
+				p[1] = (s16) Second[i];
+
+				p += nChannels;
+			}
+
+			pOutput = (u8 *) p;
+		}
+		else
+		{
+			assert (m_Format == SampleFormatInt24Packed);
+
+			// written byte-wise, the samples are not aligned
+			u8 *p = pOutput;
+			for (unsigned i = 0; i < nPiece; i++)
+			{
+				u32 nFirst = First[i];
+				p[0] = (u8) nFirst;
+				p[1] = (u8) (nFirst >> 8);
+				p[2] = (u8) (nFirst >> 16);
+
+				u32 nSecond = Second[i];
+				p[3] = (u8) nSecond;
+				p[4] = (u8) (nSecond >> 8);
+				p[5] = (u8) (nSecond >> 16);
+
+				p += nChannels*3;
+			}
+
+			pOutput = p;
+		}
+
+		pFirst += nPiece;
+		pSecond += nPiece;
+		nFrames -= nPiece;
+	}
+
+	return pOutput;
+}
+
+void CSampleConverter::ConvertLevels (const float *pLevel, u32 *pBuffer, unsigned nLevels) const
+{
+	TVector Scale = VectorSet (m_fScale);
+	TVector Null = VectorSet (m_fNullLevel);
+	TVector Min = VectorSet (m_fMinLevel);
+	TVector Max = VectorSet (m_fMaxLevel);
+
+	unsigned i = 0;
+	for (; i + VECTOR_LANES <= nLevels; i += VECTOR_LANES)
+	{
+		VectorStoreInt (&pBuffer[i], ConvertVector (VectorLoad (&pLevel[i]), Scale, Null, Min, Max));
+	}
+
+	// the rest is converted in a padded vector
+	if (i < nLevels)
+	{
+		float Level[VECTOR_LANES] = {0};
+		for (unsigned j = i; j < nLevels; j++)
+		{
+			Level[j-i] = pLevel[j];
+		}
+
+		u32 Result[VECTOR_LANES];
+		VectorStoreInt (Result, ConvertVector (VectorLoad (Level), Scale, Null, Min, Max));
+
+		for (unsigned j = i; j < nLevels; j++)
+		{
+			pBuffer[j] = Result[j-i];
+		}
+	}
+}
+
+void CSampleConverter::ConvertInterleaved (const float *pFirst, const float *pSecond,
+					   unsigned nFrames, void *pBuffer) const
+{
+	assert (   m_Format == SampleFormatInt32
+		|| m_Format == SampleFormatInt16);
+	boolean bInt16 = m_Format == SampleFormatInt16;
+
+	TVector Scale = VectorSet (m_fScale);
+	TVector Null = VectorSet (m_fNullLevel);
+	TVector Min = VectorSet (m_fMinLevel);
+	TVector Max = VectorSet (m_fMaxLevel);
+
+	unsigned i = 0;
+	if (!bInt16)
+	{
+		u32 *pOutput = (u32 *) pBuffer;
+		for (; i + VECTOR_LANES <= nFrames; i += VECTOR_LANES)
+		{
+			TVectorInt First = ConvertVector (VectorLoad (&pFirst[i]), Scale, Null, Min, Max);
+			TVectorInt Second = ConvertVector (VectorLoad (&pSecond[i]), Scale, Null, Min, Max);
+
+			VectorStoreInterleavedInt (&pOutput[i*2], First, Second);
+		}
+	}
+	else
+	{
+		s16 *pOutput = (s16 *) pBuffer;
+		for (; i + VECTOR_LANES <= nFrames; i += VECTOR_LANES)
+		{
+			TVectorInt First = ConvertVector (VectorLoad (&pFirst[i]), Scale, Null, Min, Max);
+			TVectorInt Second = ConvertVector (VectorLoad (&pSecond[i]), Scale, Null, Min, Max);
+
+			VectorStoreInterleavedInt16 (&pOutput[i*2], First, Second);
+		}
+	}
+
+	// the rest is converted in padded vectors
+	if (i < nFrames)
+	{
+		float FirstLevel[VECTOR_LANES] = {0};
+		float SecondLevel[VECTOR_LANES] = {0};
+		for (unsigned j = i; j < nFrames; j++)
+		{
+			FirstLevel[j-i] = pFirst[j];
+			SecondLevel[j-i] = pSecond[j];
+		}
+
+		TVectorInt First = ConvertVector (VectorLoad (FirstLevel), Scale, Null, Min, Max);
+		TVectorInt Second = ConvertVector (VectorLoad (SecondLevel), Scale, Null, Min, Max);
+
+		u32 Result[VECTOR_LANES*2];
+		VectorStoreInterleavedInt (Result, First, Second);
+
+		for (unsigned j = i*2; j < nFrames*2; j++)
+		{
+			if (!bInt16)
+			{
+				((u32 *) pBuffer)[j] = Result[j-i*2];
+			}
+			else
+			{
+				((s16 *) pBuffer)[j] = (s16) Result[j-i*2];
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+//
+// sampleconverter.h
+//
+// Converts the rendered stereo levels to the sample format of a sound device
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _sampleconverter_h
+#define _sampleconverter_h
+
+#include <circle/types.h>
+
+enum TSampleFormat
+{
+	SampleFormatInt32,			// one 32-bit word per sample (PWM, I2S)
+	SampleFormatInt16,			// USB
+	SampleFormatInt24Packed,		// three bytes per sample, little endian (USB)
+	SampleFormatUnknown
+};
+
+// Each level is calculated as (int) (fLevel*fScale + nNullLevel) and clamped to
+// [nMinLevel, nMaxLevel] like before in each GetChunk(), but with vector instructions
+// on VECTOR_LANES levels at once. The levels are calculated in float, which is exact
+// up to 24 bits. The samples of a frame are written left, right (or swapped) and
+// zero for the further channels of a multi-channel device.
+
+class CSampleConverter
+{
+public:
+	CSampleConverter (TSampleFormat Format, float fScale, int nNullLevel,
+			  int nMinLevel, int nMaxLevel, boolean bChannelsSwapped);
+	~CSampleConverter (void);
+
+	unsigned GetSampleSize (void) const;		// in bytes
+
+	// writes nFrames frames of nChannels (>= 2) samples to pBuffer,
+	// returns the pointer behind them
+	void *Convert (const float *pLeft, const float *pRight, unsigned nFrames,
+		       void *pBuffer, unsigned nChannels = 2) const;
+
+private:
+	// converts up to FRAMES_PER_BLOCK levels into a buffer
+	void ConvertLevels (const float *pLevel, u32 *pBuffer, unsigned nLevels) const;
+
+	// for SampleFormatInt32 and SampleFormatInt16 with 2 channels
+	void ConvertInterleaved (const float *pFirst, const float *pSecond, unsigned nFrames,
+				 void *pBuffer) const;
+
+private:
+	TSampleFormat m_Format;
+	float m_fScale;
+	float m_fNullLevel;
+	float m_fMinLevel;
+	float m_fMaxLevel;
+	boolean m_bChannelsSwapped;
+};
+
+#endif
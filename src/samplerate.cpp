@@ -0,0 +1,64 @@
+//
+// samplerate.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "samplerate.h"
+#include "filter.h"
+#include <assert.h>
+
+const unsigned CSampleRate::Supported[] = {32000, 44100, 48000, 96000, 0};
+
+unsigned CSampleRate::s_nSampleRate = SAMPLE_RATE_DEFAULT;
+
+boolean CSampleRate::Set (unsigned nSampleRate)
+{
+	if (!IsSupported (nSampleRate))
+	{
+		return FALSE;
+	}
+
+	if (nSampleRate != s_nSampleRate)
+	{
+		s_nSampleRate = nSampleRate;
+
+		CFilter::UpdateTable ();
+	}
+
+	return TRUE;
+}
+
+boolean CSampleRate::IsSupported (unsigned nSampleRate)
+{
+	for (unsigned i = 0; Supported[i] != 0; i++)
+	{
+		if (Supported[i] == nSampleRate)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+unsigned CSampleRate::Scale (unsigned nSamples)
+{
+	unsigned nResult = (unsigned) (  (u64) nSamples * s_nSampleRate
+				       + SAMPLE_RATE_DEFAULT/2) / SAMPLE_RATE_DEFAULT;
+
+	return nResult > 0 ? nResult : 1;
+}
@@ -0,0 +1,50 @@
+//
+// samplerate.h
+//
+// Holds the sample rate of the sound engine, which is selected at boot
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _samplerate_h
+#define _samplerate_h
+
+#include <circle/types.h>
+#include "config.h"
+
+// The sample rate is SAMPLE_RATE_DEFAULT, until Set() is called. This has to be
+// done before the engine is constructed and any patch is compiled, because the
+// modules calculate their coefficients, delays and stage lengths from it. The
+// tables, which depend on it, are rebuilt by Set().
+
+class CSampleRate
+{
+public:
+	static boolean Set (unsigned nSampleRate);	// returns FALSE, if not supported
+	static unsigned Get (void)			{ return s_nSampleRate; }
+
+	static boolean IsSupported (unsigned nSampleRate);
+
+	// returns the samples at the current rate for nSamples at SAMPLE_RATE_DEFAULT
+	static unsigned Scale (unsigned nSamples);
+
+	static const unsigned Supported[];		// terminated by 0
+
+private:
+	static unsigned s_nSampleRate;
+};
+
+#endif
@@ -0,0 +1,366 @@
+//
+// simd.h
+//
+// Vector operations on the voices of a voice group
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _simd_h
+#define _simd_h
+
+#include "config.h"
+#include <circle/types.h>
+#include <assert.h>
+
+// A vector holds one value for each of the VECTOR_LANES voices of a voice group.
+// SSE2 or AVX2 is used on a host and a loop over the lanes otherwise or if
+// SIMD_SCALAR is defined. NEON is used on the Raspberry Pi only, if SIMD_NEON is
+// defined, because it has not been compared with the other backends yet. Each
+// operation is one IEEE operation per lane, so that all backends calculate the same
+// results, as long as the compiler does not contract multiply and add (no FMA) and
+// does not flush denormals in one backend only (NEON on AArch32). Vectors are loaded
+// from and stored to arrays of VECTOR_LANES values, which need not be aligned.
+// TVectorInt holds unsigned 32-bit values, a comparison returns a mask in it.
+// VectorToInt() requires values in [0, 2^32) (NEON saturates other values, SSE2
+// and AVX2 wrap them around). VectorToSignedInt() truncates to signed values,
+// which are held there as their two's complement. VectorStoreInterleavedInt()
+// stores a0 b0 a1 b1 ... (for the two channels of the output),
+// VectorStoreInterleavedInt16() does the same with signed values, which fit into
+// 16 bits.
+// VectorGather() loads pBase[Index] for each lane (Index is signed here).
+// The voices of a group share their control clock, so that the output depends
+// on VECTOR_LANES too. The scalar backend can be built with 8 lanes for a test.
+
+#if defined (SIMD_SCALAR)
+	#undef SIMD_NEON
+#elif defined (SIMD_NEON)
+	#if !defined (__ARM_NEON) && !defined (__ARM_NEON__)
+		#error "SIMD_NEON requires a target with NEON"
+	#endif
+#elif defined (__AVX2__)
+	#define SIMD_AVX2
+#elif defined (__SSE2__)
+	#define SIMD_SSE2
+#else
+	#define SIMD_SCALAR
+#endif
+
+#if defined (SIMD_NEON)
+
+#include <arm_neon.h>
+
+#define VECTOR_LANES	4
+#define VECTOR_BACKEND	"neon"
+
+typedef float32x4_t TVector;
+typedef uint32x4_t TVectorInt;
+
+inline TVector VectorLoad (const float *p)		{ return vld1q_f32 (p); }
+inline void VectorStore (float *p, TVector v)		{ vst1q_f32 (p, v); }
+inline TVector VectorSet (float f)			{ return vdupq_n_f32 (f); }
+
+inline TVector VectorAdd (TVector a, TVector b)	{ return vaddq_f32 (a, b); }
+inline TVector VectorSub (TVector a, TVector b)	{ return vsubq_f32 (a, b); }
+inline TVector VectorMul (TVector a, TVector b)	{ return vmulq_f32 (a, b); }
+inline TVector VectorMin (TVector a, TVector b)	{ return vminq_f32 (a, b); }
+inline TVector VectorMax (TVector a, TVector b)	{ return vmaxq_f32 (a, b); }
+
+inline TVectorInt VectorGreater (TVector a, TVector b)	{ return vcgtq_f32 (a, b); }
+inline TVector VectorSelect (TVectorInt m, TVector a, TVector b) { return vbslq_f32 (m, a, b); }
+
+inline TVectorInt VectorLoadInt (const u32 *p)		{ return vld1q_u32 (p); }
+inline void VectorStoreInt (u32 *p, TVectorInt v)	{ vst1q_u32 (p, v); }
+inline TVectorInt VectorSetInt (u32 n)			{ return vdupq_n_u32 (n); }
+
+inline void VectorStoreInterleavedInt (u32 *p, TVectorInt a, TVectorInt b)
+{
+	uint32x4x2_t v = {{a, b}};
+	vst2q_u32 (p, v);
+}
+
+inline void VectorStoreInterleavedInt16 (s16 *p, TVectorInt a, TVectorInt b)
+{
+	int16x4x2_t v = {{vmovn_s32 (vreinterpretq_s32_u32 (a)), vmovn_s32 (vreinterpretq_s32_u32 (b))}};
+	vst2_s16 (p, v);
+}
+
+inline TVectorInt VectorAddInt (TVectorInt a, TVectorInt b)	{ return vaddq_u32 (a, b); }
+inline TVectorInt VectorAndInt (TVectorInt a, TVectorInt b)	{ return vandq_u32 (a, b); }
+inline TVectorInt VectorShiftRightInt (TVectorInt a, unsigned n)
+{
+	return vshlq_u32 (a, vdupq_n_s32 (-(int) n));
+}
+
+inline TVectorInt VectorToInt (TVector v)		{ return vcvtq_u32_f32 (v); }
+inline TVector VectorFromInt (TVectorInt v)		{ return vcvtq_f32_u32 (v); }
+inline TVectorInt VectorToSignedInt (TVector v)	{ return vreinterpretq_u32_s32 (vcvtq_s32_f32 (v)); }
+
+inline TVector VectorGather (const float *pBase, TVectorInt Index)
+{
+	TVector r = vld1q_dup_f32 (pBase + (int) vgetq_lane_u32 (Index, 0));
+	r = vld1q_lane_f32 (pBase + (int) vgetq_lane_u32 (Index, 1), r, 1);
+	r = vld1q_lane_f32 (pBase + (int) vgetq_lane_u32 (Index, 2), r, 2);
+	return vld1q_lane_f32 (pBase + (int) vgetq_lane_u32 (Index, 3), r, 3);
+}
+
+#elif defined (SIMD_AVX2)
+
+#include <immintrin.h>
+
+#define VECTOR_LANES	8
+#define VECTOR_BACKEND	"avx2"
+
+typedef __m256 TVector;
+typedef __m256i TVectorInt;
+
+inline TVector VectorLoad (const float *p)		{ return _mm256_loadu_ps (p); }
+inline void VectorStore (float *p, TVector v)		{ _mm256_storeu_ps (p, v); }
+inline TVector VectorSet (float f)			{ return _mm256_set1_ps (f); }
+
+inline TVector VectorAdd (TVector a, TVector b)	{ return _mm256_add_ps (a, b); }
+inline TVector VectorSub (TVector a, TVector b)	{ return _mm256_sub_ps (a, b); }
+inline TVector VectorMul (TVector a, TVector b)	{ return _mm256_mul_ps (a, b); }
+inline TVector VectorMin (TVector a, TVector b)	{ return _mm256_min_ps (a, b); }
+inline TVector VectorMax (TVector a, TVector b)	{ return _mm256_max_ps (a, b); }
+
+inline TVectorInt VectorGreater (TVector a, TVector b)
+{
+	return _mm256_castps_si256 (_mm256_cmp_ps (a, b, _CMP_GT_OQ));
+}
+
+inline TVector VectorSelect (TVectorInt m, TVector a, TVector b)
+{
+	return _mm256_blendv_ps (b, a, _mm256_castsi256_ps (m));
+}
+
+inline TVectorInt VectorLoadInt (const u32 *p)	{ return _mm256_loadu_si256 ((const __m256i *) p); }
+inline void VectorStoreInt (u32 *p, TVectorInt v)	{ _mm256_storeu_si256 ((__m256i *) p, v); }
+inline TVectorInt VectorSetInt (u32 n)			{ return _mm256_set1_epi32 ((int) n); }
+
+inline void VectorStoreInterleavedInt (u32 *p, TVectorInt a, TVectorInt b)
+{
+	// the unpack instructions work within the 128-bit halves
+	TVectorInt Low = _mm256_unpacklo_epi32 (a, b);		// a0 b0 a1 b1 a4 b4 a5 b5
+	TVectorInt High = _mm256_unpackhi_epi32 (a, b);		// a2 b2 a3 b3 a6 b6 a7 b7
+	_mm256_storeu_si256 ((__m256i *) p, _mm256_permute2x128_si256 (Low, High, 0x20));
+	_mm256_storeu_si256 ((__m256i *) (p+8), _mm256_permute2x128_si256 (Low, High, 0x31));
+}
+
+inline void VectorStoreInterleavedInt16 (s16 *p, TVectorInt a, TVectorInt b)
+{
+	// packs the 128-bit halves of Low and High alternately, which gives the order
+	TVectorInt Low = _mm256_unpacklo_epi32 (a, b);
+	TVectorInt High = _mm256_unpackhi_epi32 (a, b);
+	_mm256_storeu_si256 ((__m256i *) p, _mm256_packs_epi32 (Low, High));
+}
+
+inline TVectorInt VectorAddInt (TVectorInt a, TVectorInt b)	{ return _mm256_add_epi32 (a, b); }
+inline TVectorInt VectorAndInt (TVectorInt a, TVectorInt b)	{ return _mm256_and_si256 (a, b); }
+inline TVectorInt VectorShiftRightInt (TVectorInt a, unsigned n)
+{
+	return _mm256_srl_epi32 (a, _mm_cvtsi32_si128 ((int) n));
+}
+
+// there is an unsigned conversion with AVX-512 only
+inline TVectorInt VectorToInt (TVector v)
+{
+	TVector Limit = _mm256_set1_ps (2147483648.0f);
+	TVectorInt High = _mm256_castps_si256 (_mm256_cmp_ps (v, Limit, _CMP_GE_OQ));
+	v = _mm256_sub_ps (v, _mm256_and_ps (Limit, _mm256_castsi256_ps (High)));
+
+	return _mm256_xor_si256 (_mm256_cvttps_epi32 (v), _mm256_slli_epi32 (High, 31));
+}
+
+inline TVector VectorFromInt (TVectorInt v)		// v must be < 2^31
+{
+	return _mm256_cvtepi32_ps (v);
+}
+
+inline TVectorInt VectorToSignedInt (TVector v)	{ return _mm256_cvttps_epi32 (v); }
+
+inline TVector VectorGather (const float *pBase, TVectorInt Index)
+{
+	return _mm256_i32gather_ps (pBase, Index, sizeof (float));
+}
+
+#elif defined (SIMD_SSE2)
+
+#include <emmintrin.h>
+
+#define VECTOR_LANES	4
+#define VECTOR_BACKEND	"sse2"
+
+typedef __m128 TVector;
+typedef __m128i TVectorInt;
+
+inline TVector VectorLoad (const float *p)		{ return _mm_loadu_ps (p); }
+inline void VectorStore (float *p, TVector v)		{ _mm_storeu_ps (p, v); }
+inline TVector VectorSet (float f)			{ return _mm_set1_ps (f); }
+
+inline TVector VectorAdd (TVector a, TVector b)	{ return _mm_add_ps (a, b); }
+inline TVector VectorSub (TVector a, TVector b)	{ return _mm_sub_ps (a, b); }
+inline TVector VectorMul (TVector a, TVector b)	{ return _mm_mul_ps (a, b); }
+inline TVector VectorMin (TVector a, TVector b)	{ return _mm_min_ps (a, b); }
+inline TVector VectorMax (TVector a, TVector b)	{ return _mm_max_ps (a, b); }
+
+inline TVectorInt VectorGreater (TVector a, TVector b)	{ return _mm_castps_si128 (_mm_cmpgt_ps (a, b)); }
+
+inline TVector VectorSelect (TVectorInt m, TVector a, TVector b)
+{
+	TVector Mask = _mm_castsi128_ps (m);
+
+	return _mm_or_ps (_mm_and_ps (Mask, a), _mm_andnot_ps (Mask, b));
+}
+
+inline TVectorInt VectorLoadInt (const u32 *p)		{ return _mm_loadu_si128 ((const __m128i *) p); }
+inline void VectorStoreInt (u32 *p, TVectorInt v)	{ _mm_storeu_si128 ((__m128i *) p, v); }
+inline TVectorInt VectorSetInt (u32 n)			{ return _mm_set1_epi32 ((int) n); }
+
+inline void VectorStoreInterleavedInt (u32 *p, TVectorInt a, TVectorInt b)
+{
+	_mm_storeu_si128 ((__m128i *) p, _mm_unpacklo_epi32 (a, b));
+	_mm_storeu_si128 ((__m128i *) (p+4), _mm_unpackhi_epi32 (a, b));
+}
+
+inline void VectorStoreInterleavedInt16 (s16 *p, TVectorInt a, TVectorInt b)
+{
+	_mm_storeu_si128 ((__m128i *) p, _mm_packs_epi32 (_mm_unpacklo_epi32 (a, b),
+							  _mm_unpackhi_epi32 (a, b)));
+}
+
+inline TVectorInt VectorAddInt (TVectorInt a, TVectorInt b)	{ return _mm_add_epi32 (a, b); }
+inline TVectorInt VectorAndInt (TVectorInt a, TVectorInt b)	{ return _mm_and_si128 (a, b); }
+inline TVectorInt VectorShiftRightInt (TVectorInt a, unsigned n)
+{
+	return _mm_srl_epi32 (a, _mm_cvtsi32_si128 ((int) n));
+}
+
+// there is a signed conversion only
+inline TVectorInt VectorToInt (TVector v)
+{
+	TVector Limit = _mm_set1_ps (2147483648.0f);
+	TVectorInt High = _mm_castps_si128 (_mm_cmpge_ps (v, Limit));
+	v = _mm_sub_ps (v, _mm_and_ps (Limit, _mm_castsi128_ps (High)));
+
+	return _mm_xor_si128 (_mm_cvttps_epi32 (v), _mm_slli_epi32 (High, 31));
+}
+
+inline TVector VectorFromInt (TVectorInt v)		// v must be < 2^31
+{
+	return _mm_cvtepi32_ps (v);
+}
+
+inline TVectorInt VectorToSignedInt (TVector v)	{ return _mm_cvttps_epi32 (v); }
+
+inline TVector VectorGather (const float *pBase, TVectorInt Index)
+{
+	int n0 = _mm_cvtsi128_si32 (Index);
+	int n1 = _mm_cvtsi128_si32 (_mm_shuffle_epi32 (Index, 0x55));
+	int n2 = _mm_cvtsi128_si32 (_mm_shuffle_epi32 (Index, 0xAA));
+	int n3 = _mm_cvtsi128_si32 (_mm_shuffle_epi32 (Index, 0xFF));
+
+	return _mm_set_ps (pBase[n3], pBase[n2], pBase[n1], pBase[n0]);
+}
+
+#else
+
+#ifndef VECTOR_LANES
+	#define VECTOR_LANES	4		// 8 to match the output of AVX2
+#endif
+#define VECTOR_BACKEND	"scalar"
+
+struct TVector
+{
+	float f[VECTOR_LANES];
+};
+
+struct TVectorInt
+{
+	u32 n[VECTOR_LANES];
+};
+
+#define VECTOR_LOOP(expr)	for (unsigned l = 0; l < VECTOR_LANES; l++) { expr; }
+
+inline TVector VectorLoad (const float *p)	{ TVector r; VECTOR_LOOP (r.f[l] = p[l]) return r; }
+inline void VectorStore (float *p, TVector v)	{ VECTOR_LOOP (p[l] = v.f[l]) }
+inline TVector VectorSet (float f)		{ TVector r; VECTOR_LOOP (r.f[l] = f) return r; }
+
+inline TVector VectorAdd (TVector a, TVector b)	{ VECTOR_LOOP (a.f[l] += b.f[l]) return a; }
+inline TVector VectorSub (TVector a, TVector b)	{ VECTOR_LOOP (a.f[l] -= b.f[l]) return a; }
+inline TVector VectorMul (TVector a, TVector b)	{ VECTOR_LOOP (a.f[l] *= b.f[l]) return a; }
+inline TVector VectorMin (TVector a, TVector b)	{ VECTOR_LOOP (if (b.f[l] < a.f[l]) a.f[l] = b.f[l]) return a; }
+inline TVector VectorMax (TVector a, TVector b)	{ VECTOR_LOOP (if (b.f[l] > a.f[l]) a.f[l] = b.f[l]) return a; }
+
+inline TVectorInt VectorGreater (TVector a, TVector b)
+{
+	TVectorInt r;
+	VECTOR_LOOP (r.n[l] = a.f[l] > b.f[l] ? 0xFFFFFFFFU : 0)
+	return r;
+}
+
+inline TVector VectorSelect (TVectorInt m, TVector a, TVector b)
+{
+	VECTOR_LOOP (if (!m.n[l]) a.f[l] = b.f[l])
+	return a;
+}
+
+inline TVectorInt VectorLoadInt (const u32 *p)	{ TVectorInt r; VECTOR_LOOP (r.n[l] = p[l]) return r; }
+inline void VectorStoreInt (u32 *p, TVectorInt v) { VECTOR_LOOP (p[l] = v.n[l]) }
+inline TVectorInt VectorSetInt (u32 n)		{ TVectorInt r; VECTOR_LOOP (r.n[l] = n) return r; }
+
+inline void VectorStoreInterleavedInt (u32 *p, TVectorInt a, TVectorInt b)
+{
+	VECTOR_LOOP (p[2*l] = a.n[l]; p[2*l+1] = b.n[l])
+}
+
+inline void VectorStoreInterleavedInt16 (s16 *p, TVectorInt a, TVectorInt b)
+{
+	VECTOR_LOOP (p[2*l] = (s16) a.n[l]; p[2*l+1] = (s16) b.n[l])
+}
+
+inline TVectorInt VectorAddInt (TVectorInt a, TVectorInt b)	{ VECTOR_LOOP (a.n[l] += b.n[l]) return a; }
+inline TVectorInt VectorAndInt (TVectorInt a, TVectorInt b)	{ VECTOR_LOOP (a.n[l] &= b.n[l]) return a; }
+inline TVectorInt VectorShiftRightInt (TVectorInt a, unsigned n) { VECTOR_LOOP (a.n[l] >>= n) return a; }
+
+inline TVectorInt VectorToInt (TVector v)
+{
+	TVectorInt r;
+	VECTOR_LOOP (assert (0.0f <= v.f[l] && v.f[l] < 4294967296.0f); r.n[l] = (u32) v.f[l])
+	return r;
+}
+
+inline TVector VectorFromInt (TVectorInt v)	{ TVector r; VECTOR_LOOP (r.f[l] = (float) v.n[l]) return r; }
+inline TVectorInt VectorToSignedInt (TVector v)	{ TVectorInt r; VECTOR_LOOP (r.n[l] = (u32) (int) v.f[l]) return r; }
+
+inline TVector VectorGather (const float *pBase, TVectorInt Index)
+{
+	TVector r;
+	VECTOR_LOOP (r.f[l] = pBase[(int) Index.n[l]])
+	return r;
+}
+
+#undef VECTOR_LOOP
+
+#endif
+
+// The voices of a voice bank are rendered in VOICE_GROUPS groups of VECTOR_LANES
+// voices. The arrays over the voices of a bank have VOICE_LANES entries, the
+// lanes beyond VOICES_PER_CORE are never used.
+#define VOICE_GROUPS	((VOICES_PER_CORE + VECTOR_LANES-1) / VECTOR_LANES)
+#define VOICE_LANES	(VOICE_GROUPS * VECTOR_LANES)
+
+#endif
@@ -0,0 +1,311 @@
+//
+// voicebank.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "voicebank.h"
+#include "samplerate.h"
+#include <assert.h>
+
+// See: http://www.deimos.ca/notefreqs/
+static const float KeyFrequency[/* MIDI key number */] =
+{
+	8.17580, 8.66196, 9.17702, 9.72272, 10.3009, 10.9134, 11.5623, 12.2499, 12.9783, 13.7500,
+	14.5676, 15.4339, 16.3516, 17.3239, 18.3540, 19.4454, 20.6017, 21.8268, 23.1247, 24.4997,
+	25.9565, 27.5000, 29.1352, 30.8677, 32.7032, 34.6478, 36.7081, 38.8909, 41.2034, 43.6535,
+	46.2493, 48.9994, 51.9131, 55.0000, 58.2705, 61.7354, 65.4064, 69.2957, 73.4162, 77.7817,
+	82.4069, 87.3071, 92.4986, 97.9989, 103.826, 110.000, 116.541, 123.471, 130.813, 138.591,
+	146.832, 155.563, 164.814, 174.614, 184.997, 195.998, 207.652, 220.000, 233.082, 246.942,
+	261.626, 277.183, 293.665, 311.127, 329.628, 349.228, 369.994, 391.995, 415.305, 440.000,
+	466.164, 493.883, 523.251, 554.365, 587.330, 622.254, 659.255, 698.456, 739.989, 783.991,
+	830.609, 880.000, 932.328, 987.767, 1046.50, 1108.73, 1174.66, 1244.51, 1318.51, 1396.91,
+	1479.98, 1567.98, 1661.22, 1760.00, 1864.66, 1975.53, 2093.00, 2217.46, 2349.32, 2489.02,
+	2637.02, 2793.83, 2959.96, 3135.96, 3322.44, 3520.00, 3729.31, 3951.07, 4186.01, 4434.92,
+	4698.64, 4978.03, 5274.04, 5587.65, 5919.91, 6271.93, 6644.88, 7040.00, 7458.62, 7902.13,
+	8372.02, 8869.84, 9397.27, 9956.06, 10548.1, 11175.3, 11839.8, 12543.9
+};
+
+CVoiceBank::CVoiceBank (void)
+:	m_LFO_VCO (TRUE),
+	m_LFO_VCF (TRUE),
+	m_LFO_VCA (TRUE),
+	m_pPatch (0)
+{
+	for (unsigned i = 0; i < VOICE_LANES; i++)
+	{
+		m_ucKeyNumber[i] = KEY_NUMBER_NONE;
+		m_ucNextKeyNumber[i] = KEY_NUMBER_NONE;
+		m_ucNextVelocity[i] = 0;
+	}
+}
+
+CVoiceBank::~CVoiceBank (void)
+{
+	m_pPatch = 0;
+}
+
+void CVoiceBank::SetPatch (const TCompiledPatch *pPatch)
+{
+	assert (pPatch != 0);
+	if (pPatch == m_pPatch)
+	{
+		return;
+	}
+
+	m_pPatch = pPatch;
+
+	// VCO
+	m_LFO_VCO.SetParameters (&pPatch->LFO_VCO);
+	m_VCO.SetParameters (&pPatch->VCO);
+	m_VCO2.SetParameters (&pPatch->VCO2);
+
+	// VCF
+	m_LFO_VCF.SetParameters (&pPatch->LFO_VCF);
+	m_EG_VCF.SetParameters (&pPatch->EG_VCF);
+	m_VCF.SetParameters (&pPatch->VCF);
+
+	// VCA
+	m_LFO_VCA.SetParameters (&pPatch->LFO_VCA);
+	m_EG_VCA.SetParameters (&pPatch->EG_VCA);
+	m_VCA.SetParameters (&pPatch->VCA);
+}
+
+void CVoiceBank::NoteOn (unsigned nVoice, u8 ucKeyNumber, u8 ucVelocity)
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_ucNextKeyNumber[nVoice] != KEY_NUMBER_NONE)	// still fading
+	{
+		m_ucNextKeyNumber[nVoice] = ucKeyNumber;
+		m_ucNextVelocity[nVoice] = ucVelocity;
+
+		return;
+	}
+
+	if (ucKeyNumber < sizeof KeyFrequency / sizeof KeyFrequency[0])
+	{
+		m_ucKeyNumber[nVoice] = ucKeyNumber;
+		m_VCO.SetFrequency (nVoice, KeyFrequency[ucKeyNumber]);
+		m_VCO2.SetFrequency (nVoice, KeyFrequency[ucKeyNumber]);
+
+		assert (1 <= ucVelocity && ucVelocity <= 127);
+		float fVelocityLevel = ucVelocity / 127.0;
+		m_EG_VCF.NoteOn (nVoice, fVelocityLevel);
+		m_EG_VCA.NoteOn (nVoice, fVelocityLevel);
+	}
+}
+
+void CVoiceBank::NoteOff (unsigned nVoice)
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_ucNextKeyNumber[nVoice] != KEY_NUMBER_NONE)	// the next note has not started yet
+	{
+		m_ucNextKeyNumber[nVoice] = KEY_NUMBER_NONE;
+
+		return;
+	}
+
+	m_EG_VCF.NoteOff (nVoice);
+	m_EG_VCA.NoteOff (nVoice);
+}
+
+void CVoiceBank::Steal (unsigned nVoice, u8 ucKeyNumber, u8 ucVelocity)
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_EG_VCA.GetState (nVoice) == EnvelopeStateIdle)
+	{
+		m_ucNextKeyNumber[nVoice] = KEY_NUMBER_NONE;
+		NoteOn (nVoice, ucKeyNumber, ucVelocity);
+
+		return;
+	}
+
+	m_EG_VCA.Fade (nVoice, (VOICE_FADE_MS * CSampleRate::Get () + 999) / 1000);
+
+	m_ucNextKeyNumber[nVoice] = ucKeyNumber;
+	m_ucNextVelocity[nVoice] = ucVelocity;
+}
+
+TVoiceState CVoiceBank::GetState (unsigned nVoice) const
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_ucNextKeyNumber[nVoice] != KEY_NUMBER_NONE)
+	{
+		return VoiceStateActive;
+	}
+
+	switch (m_EG_VCA.GetState (nVoice))
+	{
+	case EnvelopeStateIdle:
+		return VoiceStateIdle;
+
+	case EnvelopeStateAttack:
+	case EnvelopeStateDecay:
+	case EnvelopeStateSustain:
+		return VoiceStateActive;
+
+	case EnvelopeStateRelease:
+		return VoiceStateRelease;
+
+	default:
+		assert (0);
+		return VoiceStateActive;
+	}
+}
+
+boolean CVoiceBank::IsAudible (unsigned nVoice, float fCullLevel)
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_ucNextKeyNumber[nVoice] != KEY_NUMBER_NONE)
+	{
+		return TRUE;
+	}
+
+	switch (m_EG_VCA.GetState (nVoice))
+	{
+	case EnvelopeStateIdle:
+		return FALSE;
+
+	case EnvelopeStateRelease:
+		if (m_EG_VCA.GetOutputLevel (nVoice) < fCullLevel)
+		{
+			m_EG_VCA.Stop (nVoice);
+			m_EG_VCF.Stop (nVoice);
+
+			return FALSE;
+		}
+		return TRUE;
+
+	default:
+		return TRUE;
+	}
+}
+
+u8 CVoiceBank::GetKeyNumber (unsigned nVoice) const
+{
+	assert (nVoice < VOICES_PER_CORE);
+
+	if (m_ucNextKeyNumber[nVoice] != KEY_NUMBER_NONE)
+	{
+		return m_ucNextKeyNumber[nVoice];
+	}
+
+	return   m_EG_VCA.GetState (nVoice) != EnvelopeStateIdle
+	       ? m_ucKeyNumber[nVoice] : KEY_NUMBER_NONE;
+}
+
+float CVoiceBank::GetLevel (unsigned nVoice) const
+{
+	assert (nVoice < VOICES_PER_CORE);
+	return m_EG_VCA.GetOutputLevel (nVoice);
+}
+
+void CVoiceBank::RenderBlock (u32 nVoices, float *pBuffer, unsigned nFrames)
+{
+	assert (nVoices < (1U << VOICES_PER_CORE));
+	assert (pBuffer != 0);
+	assert (nFrames <= FRAMES_PER_BLOCK);
+
+	for (unsigned nGroup = 0; nGroup < VOICE_GROUPS; nGroup++)
+	{
+		u32 nGroupVoices = (nVoices >> (nGroup * VECTOR_LANES)) & ((1U << VECTOR_LANES)-1);
+		if (nGroupVoices != 0)
+		{
+			RenderGroup (nGroup, nGroupVoices, pBuffer, nFrames);
+		}
+	}
+}
+
+void CVoiceBank::RenderGroup (unsigned nGroup, u32 nVoices, float *pBuffer, unsigned nFrames)
+{
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+
+	unsigned nFirst = nGroup * VECTOR_LANES;
+
+	for (unsigned nOffset = 0; nOffset < nFrames;)
+	{
+		// the block is split, where the fade of a stolen voice ends
+		unsigned nPart = nFrames - nOffset;
+		for (u32 nMask = nVoices; nMask != 0; nMask &= nMask-1)
+		{
+			unsigned nVoice = nFirst + __builtin_ctz (nMask);
+			if (m_ucNextKeyNumber[nVoice] == KEY_NUMBER_NONE)
+			{
+				continue;
+			}
+
+			unsigned nFade = m_EG_VCA.GetRemaining (nVoice);
+			if (nFade == 0)
+			{
+				assert (m_EG_VCA.GetState (nVoice) == EnvelopeStateIdle);
+				u8 ucKeyNumber = m_ucNextKeyNumber[nVoice];
+				m_ucNextKeyNumber[nVoice] = KEY_NUMBER_NONE;
+				NoteOn (nVoice, ucKeyNumber, m_ucNextVelocity[nVoice]);
+			}
+			else if (nFade < nPart)
+			{
+				nPart = nFade;
+			}
+		}
+
+		Render (nGroup, m_Block[nGroup][BlockVCA], nPart);
+
+		// the voices are added in the order of their number
+		const float *pBlock = m_Block[nGroup][BlockVCA];
+		float *pOutput = pBuffer + nOffset;
+		for (unsigned i = 0; i < nPart; i++)
+		{
+			for (u32 nMask = nVoices; nMask != 0; nMask &= nMask-1)
+			{
+				pOutput[i] += pBlock[i * VECTOR_LANES + __builtin_ctz (nMask)];
+			}
+		}
+
+		nOffset += nPart;
+	}
+}
+
+void CVoiceBank::Render (unsigned nGroup, float *pBuffer, unsigned nFrames)
+{
+	assert (nGroup < VOICE_GROUPS);
+	assert (pBuffer != 0);
+	assert (nFrames <= FRAMES_PER_BLOCK);
+
+	// VCO
+	m_LFO_VCO.RenderBlock (nGroup, m_Block[nGroup][BlockLFO_VCO], nFrames);
+	m_VCO.RenderBlock (nGroup, m_Block[nGroup][BlockVCO], nFrames, m_Block[nGroup][BlockLFO_VCO]);
+	m_VCO2.RenderBlock (nGroup, m_Block[nGroup][BlockVCO2], nFrames, m_Block[nGroup][BlockLFO_VCO]);
+	m_VCO_Mixer.RenderBlock (m_Block[nGroup][BlockVCO_Mixer], nFrames,
+				 m_Block[nGroup][BlockVCO], m_Block[nGroup][BlockVCO2]);
+
+	// VCF
+	m_LFO_VCF.RenderBlock (nGroup, m_Block[nGroup][BlockLFO_VCF], nFrames);
+	m_EG_VCF.RenderBlock (nGroup, m_Block[nGroup][BlockEG_VCF], nFrames);
+	m_VCF.RenderBlock (nGroup, m_Block[nGroup][BlockVCF], nFrames, m_Block[nGroup][BlockVCO_Mixer],
+			   m_Block[nGroup][BlockLFO_VCF], m_Block[nGroup][BlockEG_VCF]);
+
+	// VCA
+	m_LFO_VCA.RenderBlock (nGroup, m_Block[nGroup][BlockLFO_VCA], nFrames);
+	m_EG_VCA.RenderBlock (nGroup, m_Block[nGroup][BlockEG_VCA], nFrames);
+	m_VCA.RenderBlock (nGroup, pBuffer, nFrames, m_Block[nGroup][BlockVCF],
+			   m_Block[nGroup][BlockLFO_VCA], m_Block[nGroup][BlockEG_VCA]);
+}
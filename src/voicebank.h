@@ -0,0 +1,128 @@
+//
+// voicebank.h
+//
+// The voices of the polyphonic choir, which are rendered on one CPU core
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _voicebank_h
+#define _voicebank_h
+
+#include "oscillator.h"
+#include "mixer.h"
+#include "envelopegenerator.h"
+#include "filter.h"
+#include "amplifier.h"
+#include "patchcompiler.h"
+#include "simd.h"
+#include "config.h"
+#include <circle/types.h>
+
+enum TVoiceState
+{
+	VoiceStateIdle,
+	VoiceStateActive,
+	VoiceStateRelease,
+	VoiceStateUnknown
+};
+
+// Holds VOICES_PER_CORE voices (nVoice is the index in the bank). The state of
+// each module is stored in arrays over the voices, so that the voices of one
+// core share their cache lines and the scratch blocks. The voices are rendered
+// in groups of VECTOR_LANES voices with vector operations (see simd.h). A group
+// is rendered, if one of its voices is audible, its other voices are rendered
+// too, but are not mixed into the output. Different groups of a bank can be
+// rendered on different cores at the same time, but SetPatch() must not be
+// called meanwhile.
+
+class CVoiceBank
+{
+public:
+	CVoiceBank (void);
+	~CVoiceBank (void);
+
+	// the voices read their parameters from pPatch, which must stay valid,
+	// calling it again with the same patch does nothing
+	void SetPatch (const TCompiledPatch *pPatch);
+
+	// MIDI key number and velocity
+	void NoteOn (unsigned nVoice, u8 ucKeyNumber, u8 ucVelocity);
+	void NoteOff (unsigned nVoice);
+	// fades the playing note out within VOICE_FADE_MS and starts the new one afterwards
+	void Steal (unsigned nVoice, u8 ucKeyNumber, u8 ucVelocity);
+
+	TVoiceState GetState (unsigned nVoice) const;
+	// returns FALSE, if the voice is idle or has been released and its VCA envelope
+	// has fallen below fCullLevel, the voice is stopped then
+	boolean IsAudible (unsigned nVoice, float fCullLevel);
+	u8 GetKeyNumber (unsigned nVoice) const;	// returns KEY_NUMBER_NONE if voice is unused
+#define KEY_NUMBER_NONE		255
+	float GetLevel (unsigned nVoice) const;		// of the VCA envelope [0.0, 1.0]
+
+	// adds the output of the voices, which have their bit set in nVoices, to pBuffer
+	void RenderBlock (u32 nVoices, float *pBuffer, unsigned nFrames); // nFrames <= FRAMES_PER_BLOCK
+
+private:
+	void RenderGroup (unsigned nGroup, u32 nVoices, float *pBuffer, unsigned nFrames);
+	void Render (unsigned nGroup, float *pBuffer, unsigned nFrames);
+
+private:
+	enum TModuleBlock				// internal output blocks of the modules
+	{
+		BlockLFO_VCO,
+		BlockVCO,
+		BlockVCO2,
+		BlockVCO_Mixer,
+		BlockLFO_VCF,
+		BlockEG_VCF,
+		BlockVCF,
+		BlockLFO_VCA,
+		BlockEG_VCA,
+		BlockVCA,
+		BlockUnknown
+	};
+
+private:
+	// VCO
+	COscillator m_LFO_VCO;
+	COscillator m_VCO;
+	COscillator m_VCO2;
+	CMixer m_VCO_Mixer;
+
+	// VCF
+	COscillator m_LFO_VCF;
+	CEnvelopeGenerator m_EG_VCF;
+	CFilter m_VCF;
+
+	// VCA
+	COscillator m_LFO_VCA;
+	CEnvelopeGenerator m_EG_VCA;
+	CAmplifier m_VCA;
+
+	const TCompiledPatch *m_pPatch;
+
+	u8 m_ucKeyNumber[VOICE_LANES];
+
+	// played after the fade, if not KEY_NUMBER_NONE
+	u8 m_ucNextKeyNumber[VOICE_LANES];
+	u8 m_ucNextVelocity[VOICE_LANES];
+
+	// each group has its own blocks, so that the groups can be rendered on different cores
+	float m_Block[VOICE_GROUPS][BlockUnknown][FRAMES_PER_BLOCK * VECTOR_LANES];
+};
+
+#endif
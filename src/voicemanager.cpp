@@ -2,7 +2,7 @@
 // voicemanager.cpp
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -18,51 +18,115 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 #include "voicemanager.h"
+#include <circle/util.h>
+#include <circle/new.h>
 #include <assert.h>
+#include "math.h"
+
+static_assert (VOICES <= 32, "Active voices must fit into u32");
+
+#ifdef ARM_ALLOW_MULTI_CORE
+static_assert (RENDER_CORE < EFFECTS_CORE, "EFFECTS_CORE must follow RENDER_CORE");
+#endif
+
+static const char *VoiceStealingName[VoiceStealingUnknown] =
+{
+	"none",
+	"oldest",
+	"quietest",
+	"released"
+};
 
 CVoiceManager::CVoiceManager (CMemorySystem *pMemorySystem)
 :
 #ifdef ARM_ALLOW_MULTI_CORE
 	CMultiCoreSupport (pMemorySystem),
 #endif
-	m_nLastNoteOnVoice (VOICES)
+	m_pVoiceBankBuffer (0),
+	m_pPatch (0),
+	m_VoiceStealing (GetVoiceStealing (0)),
+	m_bRetrigger (TRUE),
+	m_nNextSerial (0),
+	m_nActiveVoices (0),
+	m_fCullThreshold (0.0),
+	m_fCullLevel (0.0),
+	m_fVolume (0.0),
+#ifdef ARM_ALLOW_MULTI_CORE
+	m_pRenderAheadHandler (0),
+	m_pRenderAheadParam (0),
+	m_bRenderAheadStop (FALSE),
+	m_bEffectsCore (FALSE),
+	m_bEffectsStop (FALSE),
+	m_nEffectsWrite (0),
+	m_nEffectsRead (0),
+	m_nPendingFrames (0),
+#endif
+	m_nFrames (0),
+	m_nGroupCount (0)
 {
-	for (unsigned i = 0; i < VOICES; i++)
+	m_GroupCounter.nNext = 0;
+
+	for (unsigned i = 0; i < sizeof m_ucKeyVoice; i++)
 	{
-		m_pVoice[i] = new CVoice ();
-		assert (m_pVoice[i] != 0);
+		m_ucKeyVoice[i] = VOICE_NONE;
 	}
 
-#ifdef ARM_ALLOW_MULTI_CORE
-	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	for (unsigned i = 0; i < VoiceListUnknown; i++)
 	{
-		m_CoreStatus[nCore] = CoreStatusInit;
+		m_ucHead[i] = VOICE_NONE;
+		m_ucTail[i] = VOICE_NONE;
+	}
+
+	// the banks are placed on cache line boundaries
+	const unsigned nStride = (sizeof (CVoiceBank) + CACHE_LINE_SIZE-1) & ~(CACHE_LINE_SIZE-1);
+	m_pVoiceBankBuffer = new u8[VOICE_BANKS * nStride + CACHE_LINE_SIZE-1];
+	assert (m_pVoiceBankBuffer != 0);
 
-		m_fOutputLevel[nCore] = 0.0;
+	uintptr nBank =   ((uintptr) m_pVoiceBankBuffer + CACHE_LINE_SIZE-1)
+			& ~((uintptr) CACHE_LINE_SIZE-1);
+	for (unsigned i = 0; i < VOICE_BANKS; i++)
+	{
+		m_pVoiceBank[i] = new ((void *) nBank) CVoiceBank;
+		nBank += nStride;
 	}
-#endif
+
+	for (unsigned i = 0; i < VOICES; i++)
+	{
+		m_ucVoiceKey[i] = KEY_NUMBER_NONE;
+		m_nNoteOnSerial[i] = 0;
+
+		Append (VoiceListFree, i);
+	}
+
+	CReverbModule::CompileParameters (0.0f, 0.0f, &m_ReverbParameters);	// until SetPatch()
+
+	SetCullLevel (VOICE_CULL_DB);
 }
 
 CVoiceManager::~CVoiceManager (void)
 {
 #ifdef ARM_ALLOW_MULTI_CORE
-	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	if (m_pRenderAheadHandler != 0)
 	{
-		assert (m_CoreStatus[nCore] == CoreStatusIdle);
-		m_CoreStatus[nCore] = CoreStatusExit;
+		StopRenderAhead ();
+	}
 
-		while (m_CoreStatus[nCore] == CoreStatusExit)
-		{
-			// just wait
-		}
+	SetEffectsCore (FALSE);
+
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		m_CoreSync.Exit (nCore);
 	}
 #endif
 
-	for (unsigned i = 0; i < VOICES; i++)
+	for (unsigned i = 0; i < VOICE_BANKS; i++)
 	{
-		delete m_pVoice[i];
-		m_pVoice[i] = 0;
+		m_pVoiceBank[i]->~CVoiceBank ();
+		m_pVoiceBank[i] = 0;
 	}
+
+	delete [] m_pVoiceBankBuffer;
+	m_pVoiceBankBuffer = 0;
 }
 
 boolean CVoiceManager::Initialize (void)
@@ -76,10 +140,7 @@ boolean CVoiceManager::Initialize (void)
 	// wait for secondary cores to be ready
 	for (unsigned nCore = 1; nCore < CORES; nCore++)
 	{
-		while (m_CoreStatus[nCore] != CoreStatusIdle)
-		{
-			// just wait
-		}
+		m_CoreSync.WaitForIdle (nCore);
 	}
 #endif
 
@@ -91,165 +152,690 @@ boolean CVoiceManager::Initialize (void)
 void CVoiceManager::Run (unsigned nCore)	// runs on secondary cores
 {
 	assert (1 <= nCore && nCore < CORES);
-	unsigned nFirstVoice = nCore * VOICES_PER_CORE;
-	unsigned nLastVoice  = nFirstVoice + VOICES_PER_CORE-1;
 
-	while (1)
+	while (m_CoreSync.WaitForKick (nCore))
 	{
-		m_CoreStatus[nCore] = CoreStatusIdle;			// ready to be kicked
-		while (m_CoreStatus[nCore] == CoreStatusIdle)
+		if (   nCore == RENDER_CORE
+		    && m_pRenderAheadHandler != 0)
+		{
+			RenderAhead ();
+		}
+		else if (   nCore == EFFECTS_CORE
+			 && m_bEffectsCore)
 		{
-			// just wait
+			ProcessEffects ();
 		}
+		else
+		{
+			ProcessGroups ();
+		}
+	}
+}
 
-		if (m_CoreStatus[nCore] == CoreStatusExit)
+void CVoiceManager::StartRenderAhead (TRenderAheadHandler *pHandler, void *pParam)
+{
+	assert (pHandler != 0);
+	assert (m_pRenderAheadHandler == 0);
+	m_pRenderAheadHandler = pHandler;
+	m_pRenderAheadParam = pParam;
+	m_bRenderAheadStop = FALSE;
+
+	m_CoreSync.Kick (RENDER_CORE);
+}
+
+void CVoiceManager::StopRenderAhead (void)
+{
+	assert (m_pRenderAheadHandler != 0);
+	__atomic_store_n (&m_bRenderAheadStop, TRUE, __ATOMIC_RELEASE);
+	CCoreSync::SendEvent ();
+
+	m_CoreSync.WaitForIdle (RENDER_CORE);
+
+	m_pRenderAheadHandler = 0;
+	m_pRenderAheadParam = 0;
+}
+
+void CVoiceManager::SetEffectsCore (boolean bOn)
+{
+	if (bOn == m_bEffectsCore)
+	{
+		return;
+	}
+
+	if (bOn)
+	{
+		m_bEffectsStop = FALSE;
+		m_bEffectsCore = TRUE;
+
+		m_CoreSync.Kick (EFFECTS_CORE);
+	}
+	else
+	{
+		// the pending parts are processed before EFFECTS_CORE goes idle
+		__atomic_store_n (&m_bEffectsStop, TRUE, __ATOMIC_RELEASE);
+		CCoreSync::SendEvent ();
+
+		m_CoreSync.WaitForIdle (EFFECTS_CORE);
+
+		m_bEffectsCore = FALSE;
+	}
+}
+
+void CVoiceManager::PingCores (void)
+{
+	assert (m_pRenderAheadHandler == 0);
+	assert (!m_bEffectsCore);
+	assert (m_nGroupCount == 0);		// ProcessGroups() does nothing
+
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		m_CoreSync.Kick (nCore);
+	}
+
+	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	{
+		m_CoreSync.WaitForIdle (nCore);
+	}
+}
+
+void CVoiceManager::ProcessEffects (void)
+{
+	for (;;)
+	{
+		u32 nRead = m_nEffectsRead;
+		if (nRead == __atomic_load_n (&m_nEffectsWrite, __ATOMIC_ACQUIRE))
 		{
-			m_CoreStatus[nCore] = CoreStatusUnknown;
+			if (__atomic_load_n (&m_bEffectsStop, __ATOMIC_ACQUIRE))
+			{
+				break;
+			}
 
-			return;
+			CCoreSync::WaitForEvent ();
+
+			continue;
+		}
+
+		const TEffectsPart *pPart = &m_EffectsPart[nRead % EFFECTS_PARTS];
+		unsigned nFrames = pPart->nFrames;
+
+		// the consumer of the ring makes room
+		while (pPart->pOutput->GetFree () < nFrames)
+		{
+			CCoreSync::WaitForEvent ();
 		}
 
-		assert (m_CoreStatus[nCore] == CoreStatusBusy);
+		RenderEffects (pPart->Dry, nFrames, &pPart->Reverb, pPart->fVolume, pPart->pOutput);
+
+		// free the entry, after it has been read
+		__atomic_store_n (&m_nEffectsRead, nRead+1, __ATOMIC_RELEASE);
+		__atomic_fetch_sub (&m_nPendingFrames, nFrames, __ATOMIC_RELEASE);
+		CCoreSync::SendEvent ();
+	}
+}
+
+void CVoiceManager::RenderAhead (void)
+{
+	assert (m_pRenderAheadHandler != 0);
 
-		m_fOutputLevel[nCore] = ProcessVoices (nFirstVoice, nLastVoice);
+	while (!__atomic_load_n (&m_bRenderAheadStop, __ATOMIC_ACQUIRE))
+	{
+		if (!(*m_pRenderAheadHandler) (m_pRenderAheadParam))
+		{
+			CCoreSync::WaitForEvent ();
+		}
 	}
 }
 
 #endif
 
-void CVoiceManager::SetPatch (CPatch *pPatch)
+void CVoiceManager::SetPatch (const TCompiledPatch *pPatch)
 {
 	assert (pPatch != 0);
+	m_pPatch = pPatch;
 
-	for (unsigned i = 0; i < VOICES; i++)
-	{
-		assert (m_pVoice[i] != 0);
-		m_pVoice[i]->SetPatch (pPatch);
-	}
+	// applied to the next chunk, which may be processed on EFFECTS_CORE
+	m_ReverbParameters = pPatch->Reverb;
+	m_fVolume = pPatch->fVolume;
 
-	m_ReverbModule.SetDecay (pPatch->GetParameter (ReverbDecay) / 100.0f);
-	m_ReverbModule.SetWetDryRatio (pPatch->GetParameter (ReverbVolume) / 100.0f);
+	UpdateCullLevel ();		// the volume may have changed
 }
 
-void CVoiceManager::NoteOn (u8 ucKeyNumber, u8 ucVelocity)
+void CVoiceManager::SetVoiceStealing (TVoiceStealing Policy, boolean bRetrigger)
+{
+	assert (Policy < VoiceStealingUnknown);
+	m_VoiceStealing = Policy;
+	m_bRetrigger = bRetrigger;
+}
+
+void CVoiceManager::SetCullLevel (unsigned nLevelDB)
 {
-	// find the voice which is currently playing this key
+	m_fCullThreshold = nLevelDB != 0 ? powf (10.0f, nLevelDB / -20.0f) : 0.0f;
+
+	UpdateCullLevel ();
+}
+
+TVoiceStealing CVoiceManager::GetVoiceStealing (const char *pName)
+{
+	if (pName == 0)
+	{
+#ifdef LAST_NOTE_PRIORITY
+		return VoiceStealingReleasedFirst;
+#else
+		return VoiceStealingNone;
+#endif
+	}
+
 	unsigned i;
-	for (i = 0; i < VOICES; i++)
+	for (i = 0; i < VoiceStealingUnknown; i++)
 	{
-		assert (m_pVoice[i] != 0);
-		if (m_pVoice[i]->GetKeyNumber () == ucKeyNumber)
+		if (strcmp (pName, VoiceStealingName[i]) == 0)
 		{
 			break;
 		}
 	}
 
-	if (i >= VOICES)
+	return (TVoiceStealing) i;
+}
+
+void CVoiceManager::NoteOn (u8 ucKeyNumber, u8 ucVelocity)
+{
+	if (   m_pPatch == 0				// no patch set yet
+	    || ucKeyNumber >= sizeof m_ucKeyVoice)
 	{
-		// otherwise find a free voice
-		for (i = 0; i < VOICES; i++)
+		return;
+	}
+
+	unsigned nVoice = m_ucKeyVoice[ucKeyNumber];
+	if (nVoice != VOICE_NONE)
+	{
+		if (m_bRetrigger)
 		{
-			assert (m_pVoice[i] != 0);
-			if (m_pVoice[i]->GetState () == VoiceStateIdle)
-			{
-				break;
-			}
+			// the voice, which is currently playing this key, is used again
+			CVoiceBank *pBank = GetBank (nVoice);
+			pBank->SetPatch (m_pPatch);
+			pBank->NoteOn (GetLane (nVoice), ucKeyNumber, ucVelocity);
+
+			Remove (nVoice);
+			Append (VoiceListHeld, nVoice);
+			m_nNoteOnSerial[nVoice] = m_nNextSerial++;
+
+			return;
 		}
+
+		NoteOff (ucKeyNumber);
 	}
 
-	if (i < VOICES)
+	boolean bSteal = FALSE;
+	nVoice = GetFreeVoice ();
+	if (nVoice == VOICE_NONE)
 	{
-		assert (m_pVoice[i] != 0);
-		m_pVoice[i]->NoteOn (ucKeyNumber, ucVelocity);
+		nVoice = StealVoice ();
+		if (nVoice == VOICE_NONE)
+		{
+			return;
+		}
+
+		bSteal = TRUE;
+
+		u8 ucOldKeyNumber = m_ucVoiceKey[nVoice];
+		assert (ucOldKeyNumber < sizeof m_ucKeyVoice);
+		if (m_ucKeyVoice[ucOldKeyNumber] == nVoice)
+		{
+			m_ucKeyVoice[ucOldKeyNumber] = VOICE_NONE;
+		}
+	}
+
+	Remove (nVoice);
+	Append (VoiceListHeld, nVoice);
+	m_nNoteOnSerial[nVoice] = m_nNextSerial++;
+	m_nActiveVoices |= 1U << nVoice;
+
+	m_ucVoiceKey[nVoice] = ucKeyNumber;
+	m_ucKeyVoice[ucKeyNumber] = nVoice;
 
-		m_nLastNoteOnVoice = i;
+	CVoiceBank *pBank = GetBank (nVoice);
+	pBank->SetPatch (m_pPatch);
+	if (!bSteal)
+	{
+		pBank->NoteOn (GetLane (nVoice), ucKeyNumber, ucVelocity);
 	}
-#ifdef LAST_NOTE_PRIORITY
 	else
 	{
-		assert (m_nLastNoteOnVoice < VOICES);
-		assert (m_pVoice[m_nLastNoteOnVoice] != 0);
-		m_pVoice[m_nLastNoteOnVoice]->NoteOn (ucKeyNumber, ucVelocity);
+		pBank->Steal (GetLane (nVoice), ucKeyNumber, ucVelocity);
 	}
-#endif
 }
 
 void CVoiceManager::NoteOff (u8 ucKeyNumber)
 {
-	// find the voice used for this key
-	unsigned i;
-	for (i = 0; i < VOICES; i++)
+	if (ucKeyNumber >= sizeof m_ucKeyVoice)
 	{
-		assert (m_pVoice[i] != 0);
-		if (m_pVoice[i]->GetKeyNumber () == ucKeyNumber)
-		{
-			break;
-		}
+		return;
 	}
 
-	if (i < VOICES)
+	// the key stays mapped to the voice until it is idle, so that it can be retriggered
+	unsigned nVoice = m_ucKeyVoice[ucKeyNumber];
+	if (   nVoice == VOICE_NONE
+	    || m_VoiceList[nVoice] != VoiceListHeld)
 	{
-		assert (m_pVoice[i] != 0);
-		m_pVoice[i]->NoteOff ();
+		return;
 	}
+
+	assert (m_pPatch != 0);				// the voice is not idle
+	CVoiceBank *pBank = GetBank (nVoice);
+	pBank->SetPatch (m_pPatch);
+	pBank->NoteOff (GetLane (nVoice));
+
+	Remove (nVoice);
+	Append (VoiceListReleased, nVoice);
 }
 
-void CVoiceManager::NextSample (void)		// runs on core 0
+void CVoiceManager::RenderChunk (unsigned nFrames, CRenderRing *pOutput)	// runs on core 0 or RENDER_CORE
 {
+	assert (nFrames <= MAX_FRAMES_PER_CHUNK);
+	assert (pOutput != 0);
+	m_nFrames = nFrames;
+
+	// the banks must not pick up a new patch, while the cores are rendering
+	if (m_pPatch != 0)
+	{
+		for (unsigned i = 0; i < VOICE_BANKS; i++)
+		{
+			m_pVoiceBank[i]->SetPatch (m_pPatch);
+		}
+	}
+	else
+	{
+		assert (m_nActiveVoices == 0);
+	}
+
+	m_nGroupCount = 0;
+	for (unsigned nGroup = 0; nGroup < GROUPS; nGroup++)
+	{
+		if (m_nActiveVoices & GetGroupVoices (nGroup))
+		{
+			m_ucGroupList[m_nGroupCount++] = nGroup;
+		}
+	}
+
+	// nothing to do, if the voices are idle and the reverb tail has faded out
+	// (EFFECTS_CORE does not use the reverb module without pending frames)
+	if (   m_nGroupCount == 0
+	    && GetPendingFrames () == 0
+	    && m_ReverbModule.IsIdle ())
+	{
+		pOutput->WriteSilence (nFrames);
+
+		return;
+	}
+
+	__atomic_store_n (&m_GroupCounter.nNext, 0, __ATOMIC_RELAXED);
+
 #ifdef ARM_ALLOW_MULTI_CORE
-	// kick secondary cores
-	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	// kick the secondary cores after this one, which are needed
+	unsigned nFirstCore = m_pRenderAheadHandler != 0 ? RENDER_CORE : 0;
+	unsigned nEndCore = m_bEffectsCore ? EFFECTS_CORE : CORES;
+	unsigned nCores = m_nGroupCount < nEndCore - nFirstCore ? m_nGroupCount : nEndCore - nFirstCore;
+	for (unsigned nCore = nFirstCore+1; nCore < nFirstCore+nCores; nCore++)
 	{
-		assert (m_CoreStatus[nCore] == CoreStatusIdle);
-		m_CoreStatus[nCore] = CoreStatusBusy;
+		m_CoreSync.Kick (nCore);
 	}
 
-	m_fOutputLevel[0] = ProcessVoices (0, VOICES_PER_CORE-1);
+	ProcessGroups ();
 
 	// wait for secondary cores to complete their work
-	for (unsigned nCore = 1; nCore < CORES; nCore++)
+	for (unsigned nCore = nFirstCore+1; nCore < nFirstCore+nCores; nCore++)
 	{
-		while (m_CoreStatus[nCore] != CoreStatusIdle)
+		m_CoreSync.WaitForIdle (nCore);
+	}
+
+	TEffectsPart *pPart = 0;
+	float *pBuffer = m_Buffer;
+	if (m_bEffectsCore)
+	{
+		// wait for a free entry, EFFECTS_CORE is still busy with the previous parts
+		while (m_nEffectsWrite - __atomic_load_n (&m_nEffectsRead, __ATOMIC_ACQUIRE)
+		       == EFFECTS_PARTS)
 		{
-			// just wait
+			CCoreSync::WaitForEvent ();
 		}
+
+		pPart = &m_EffectsPart[m_nEffectsWrite % EFFECTS_PARTS];
+		pBuffer = pPart->Dry;
+	}
+#else
+	ProcessGroups ();
+
+	float *pBuffer = m_Buffer;
+#endif
+
+	for (unsigned i = 0; i < nFrames; i++)
+	{
+		pBuffer[i] = 0.0f;
 	}
 
-	float fLevel = 0.0;
-	for (unsigned nCore = 0; nCore < CORES; nCore++)
+	for (unsigned j = 0; j < m_nGroupCount; j++)
 	{
-		fLevel += m_fOutputLevel[nCore];
+		const float *pGroupBuffer = m_GroupBuffer[m_ucGroupList[j]];
+		for (unsigned i = 0; i < nFrames; i++)
+		{
+			pBuffer[i] += pGroupBuffer[i];
+		}
 	}
 
-	m_ReverbModule.NextSample (fLevel);
+#ifdef ARM_ALLOW_MULTI_CORE
+	if (pPart != 0)
+	{
+		pPart->nFrames = nFrames;
+		pPart->Reverb = m_ReverbParameters;
+		pPart->fVolume = m_fVolume;
+		pPart->pOutput = pOutput;
+
+		__atomic_fetch_add (&m_nPendingFrames, nFrames, __ATOMIC_RELAXED);
+
+		// publish the part, after it has been written
+		__atomic_store_n (&m_nEffectsWrite, m_nEffectsWrite+1, __ATOMIC_RELEASE);
+		CCoreSync::SendEvent ();
+	}
+	else
+#endif
+	{
+		RenderEffects (pBuffer, nFrames, &m_ReverbParameters, m_fVolume, pOutput);
+	}
+
+	ReclaimVoices ();
+}
+
+unsigned CVoiceManager::GetPendingFrames (void) const
+{
+#ifdef ARM_ALLOW_MULTI_CORE
+	return __atomic_load_n (&m_nPendingFrames, __ATOMIC_ACQUIRE);
 #else
-	m_ReverbModule.NextSample (ProcessVoices (0, VOICES-1));
+	return 0;
 #endif
 }
 
-float CVoiceManager::GetOutputLevelLeft (void) const
+void CVoiceManager::RenderEffects (const float *pDry, unsigned nFrames,
+				   const TReverbParameters *pReverb, float fVolume,
+				   CRenderRing *pOutput)
+{
+	assert (pOutput != 0);
+
+	m_ReverbModule.SetParameters (pReverb);
+	m_ReverbModule.RenderBlock (pDry, m_OutputLeft, m_OutputRight, nFrames);
+
+	pOutput->Write (m_OutputLeft, m_OutputRight, nFrames, fVolume);
+}
+
+void CVoiceManager::ProcessGroups (void)
+{
+	unsigned nIndex;
+	while ((nIndex = __atomic_fetch_add (&m_GroupCounter.nNext, 1, __ATOMIC_RELAXED))
+	       < m_nGroupCount)
+	{
+		ProcessGroup (m_ucGroupList[nIndex]);
+	}
+}
+
+void CVoiceManager::ProcessGroup (unsigned nGroup)
 {
-	return m_ReverbModule.GetOutputLevelLeft ();
+	assert (nGroup < GROUPS);
+
+	unsigned nFrames = m_nFrames;
+	assert (nFrames <= MAX_FRAMES_PER_CHUNK);
+
+	float *pBuffer = m_GroupBuffer[nGroup];
+	for (unsigned i = 0; i < nFrames; i++)
+	{
+		pBuffer[i] = 0.0f;
+	}
+
+	float fCullLevel = m_fCullLevel;
+
+	// the voices of the group as lanes of its bank
+	unsigned nBank = nGroup / VOICE_GROUPS;
+	CVoiceBank *pBank = m_pVoiceBank[nBank];
+	u32 nVoices = (m_nActiveVoices & GetGroupVoices (nGroup)) >> (nBank * VOICES_PER_CORE);
+	assert (nVoices != 0);
+
+	// the bank renders the audible voices of the group block by block
+	for (unsigned nOffset = 0; nOffset < nFrames; nOffset += FRAMES_PER_BLOCK)
+	{
+		// a voice, which is not audible, remains so for the rest of the chunk
+		for (u32 nMask = nVoices; nMask != 0; nMask &= nMask-1)
+		{
+			unsigned i = __builtin_ctz (nMask);
+			if (!pBank->IsAudible (i, fCullLevel))
+			{
+				nVoices &= ~(1U << i);
+			}
+		}
+
+		if (nVoices == 0)
+		{
+			break;
+		}
+
+		unsigned nBlockFrames = nFrames - nOffset;
+		if (nBlockFrames > FRAMES_PER_BLOCK)
+		{
+			nBlockFrames = FRAMES_PER_BLOCK;
+		}
+
+		pBank->RenderBlock (nVoices, pBuffer + nOffset, nBlockFrames);
+	}
+}
+
+u32 CVoiceManager::GetGroupVoices (unsigned nGroup)
+{
+	assert (nGroup < GROUPS);
+
+	unsigned nFirstLane = nGroup % VOICE_GROUPS * VECTOR_LANES;
+	unsigned nLanes = VOICES_PER_CORE - nFirstLane;
+	if (nLanes > VECTOR_LANES)
+	{
+		nLanes = VECTOR_LANES;
+	}
+
+	return ((1U << nLanes) - 1) << (nGroup / VOICE_GROUPS * VOICES_PER_CORE + nFirstLane);
+}
+
+unsigned CVoiceManager::GetFreeVoice (void) const
+{
+	// a group costs the same, however many of its voices are active, and the
+	// critical path of a chunk grows with the number of active groups only
+	unsigned nFullestGroup = GROUPS;
+	unsigned nMaxActive = 0;
+	for (unsigned nGroup = 0; nGroup < GROUPS; nGroup++)
+	{
+		u32 nGroupVoices = GetGroupVoices (nGroup);
+		u32 nActive = m_nActiveVoices & nGroupVoices;
+		if (   nActive != 0
+		    && nActive != nGroupVoices)
+		{
+			unsigned nCount = __builtin_popcount (nActive);
+			if (nCount > nMaxActive)
+			{
+				nMaxActive = nCount;
+				nFullestGroup = nGroup;
+			}
+		}
+	}
+
+	if (nFullestGroup < GROUPS)
+	{
+		return __builtin_ctz (GetGroupVoices (nFullestGroup) & ~m_nActiveVoices);
+	}
+
+	// a new group is needed, take the last used voice, which is still in the cache
+	return m_ucHead[VoiceListFree];
 }
 
-float CVoiceManager::GetOutputLevelRight (void) const
+unsigned CVoiceManager::StealVoice (void) const
 {
-	return m_ReverbModule.GetOutputLevelRight ();
+	unsigned nHeld = m_ucHead[VoiceListHeld];
+	unsigned nReleased = m_ucHead[VoiceListReleased];
+
+	switch (m_VoiceStealing)
+	{
+	case VoiceStealingNone:
+		return VOICE_NONE;
+
+	case VoiceStealingOldest:
+		if (   nHeld == VOICE_NONE
+		    || (   nReleased != VOICE_NONE
+			&& (int) (m_nNoteOnSerial[nReleased] - m_nNoteOnSerial[nHeld]) < 0))
+		{
+			return nReleased;
+		}
+		return nHeld;
+
+	case VoiceStealingQuietest: {
+		unsigned nQuietest = VOICE_NONE;
+		float fMinLevel = 2.0;
+		for (unsigned nVoice = nReleased; nVoice != VOICE_NONE; nVoice = m_ucNext[nVoice])
+		{
+			float fLevel = GetBank (nVoice)->GetLevel (GetLane (nVoice));
+			if (fLevel < fMinLevel)
+			{
+				fMinLevel = fLevel;
+				nQuietest = nVoice;
+			}
+		}
+
+		for (unsigned nVoice = nHeld; nVoice != VOICE_NONE; nVoice = m_ucNext[nVoice])
+		{
+			float fLevel = GetBank (nVoice)->GetLevel (GetLane (nVoice));
+			if (fLevel < fMinLevel)
+			{
+				fMinLevel = fLevel;
+				nQuietest = nVoice;
+			}
+		}
+
+		return nQuietest;
+		}
+
+	case VoiceStealingReleasedFirst:
+		return nReleased != VOICE_NONE ? nReleased : nHeld;
+
+	default:
+		assert (0);
+		return VOICE_NONE;
+	}
 }
 
-float CVoiceManager::ProcessVoices (unsigned nFirst, unsigned nLast)
+void CVoiceManager::ReclaimVoices (void)
 {
-	float fLevel = 0.0;
-	for (unsigned i = nFirst; i <= nLast; i++)
+	for (u32 nVoices = m_nActiveVoices; nVoices != 0; nVoices &= nVoices-1)
 	{
-		assert (m_pVoice[i] != 0);
-		if (m_pVoice[i]->GetState () != VoiceStateIdle)
+		unsigned nVoice = __builtin_ctz (nVoices);
+
+		if (GetBank (nVoice)->GetState (GetLane (nVoice)) != VoiceStateIdle)
 		{
-			m_pVoice[i]->NextSample ();
+			continue;
+		}
 
-			fLevel += m_pVoice[i]->GetOutputLevel ();
+		u8 ucKeyNumber = m_ucVoiceKey[nVoice];
+		assert (ucKeyNumber < sizeof m_ucKeyVoice);
+		if (m_ucKeyVoice[ucKeyNumber] == nVoice)
+		{
+			m_ucKeyVoice[ucKeyNumber] = VOICE_NONE;
 		}
+		m_ucVoiceKey[nVoice] = KEY_NUMBER_NONE;
+
+		Remove (nVoice);
+		Prepend (VoiceListFree, nVoice);		// is still in the cache
+		m_nActiveVoices &= ~(1U << nVoice);
+	}
+}
+
+void CVoiceManager::UpdateCullLevel (void)
+{
+	if (m_pPatch == 0)
+	{
+		return;
+	}
+
+	// the maximum output level of a voice is its VCA envelope level multiplied by this
+	float fGain = (1.0f + m_pPatch->VCA.fModulationVolume) * m_pPatch->fVolume;
+
+	if (m_fCullThreshold == 0.0f)			// disabled
+	{
+		m_fCullLevel = 0.0f;
+	}
+	else if (fGain > 0.0f)
+	{
+		m_fCullLevel = m_fCullThreshold / fGain;
+	}
+	else						// nothing is audible
+	{
+		m_fCullLevel = 1.0f;
+	}
+}
+
+void CVoiceManager::Append (TVoiceList List, unsigned nVoice)
+{
+	assert (List < VoiceListUnknown);
+	assert (nVoice < VOICES);
+
+	m_VoiceList[nVoice] = List;
+	m_ucNext[nVoice] = VOICE_NONE;
+	m_ucPrev[nVoice] = m_ucTail[List];
+
+	if (m_ucTail[List] != VOICE_NONE)
+	{
+		m_ucNext[m_ucTail[List]] = nVoice;
 	}
+	else
+	{
+		m_ucHead[List] = nVoice;
+	}
+
+	m_ucTail[List] = nVoice;
+}
 
-	return fLevel;
+void CVoiceManager::Prepend (TVoiceList List, unsigned nVoice)
+{
+	assert (List < VoiceListUnknown);
+	assert (nVoice < VOICES);
+
+	m_VoiceList[nVoice] = List;
+	m_ucPrev[nVoice] = VOICE_NONE;
+	m_ucNext[nVoice] = m_ucHead[List];
+
+	if (m_ucHead[List] != VOICE_NONE)
+	{
+		m_ucPrev[m_ucHead[List]] = nVoice;
+	}
+	else
+	{
+		m_ucTail[List] = nVoice;
+	}
+
+	m_ucHead[List] = nVoice;
+}
+
+void CVoiceManager::Remove (unsigned nVoice)
+{
+	assert (nVoice < VOICES);
+	TVoiceList List = m_VoiceList[nVoice];
+	assert (List < VoiceListUnknown);
+
+	if (m_ucPrev[nVoice] != VOICE_NONE)
+	{
+		m_ucNext[m_ucPrev[nVoice]] = m_ucNext[nVoice];
+	}
+	else
+	{
+		m_ucHead[List] = m_ucNext[nVoice];
+	}
+
+	if (m_ucNext[nVoice] != VOICE_NONE)
+	{
+		m_ucPrev[m_ucNext[nVoice]] = m_ucPrev[nVoice];
+	}
+	else
+	{
+		m_ucTail[List] = m_ucPrev[nVoice];
+	}
 }
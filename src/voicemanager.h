@@ -4,7 +4,7 @@
 // Manages the polyphonic voices and available CPU cores
 //
 // MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
-// Copyright (C) 2017-2020  R. Stange <rsta2@o2online.de>
+// Copyright (C) 2017-2026  R. Stange <rsta2@o2online.de>
 //
 // This program is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,39 +25,86 @@
 #include <circle/multicore.h>
 #include <circle/memory.h>
 #include <circle/types.h>
-#include "patch.h"
-#include "voice.h"
+#include "patchcompiler.h"
+#include "voicebank.h"
 #include "reverbmodule.h"
+#include "renderring.h"
+#include "coresync.h"
 #include "config.h"
 
 #ifdef ARM_ALLOW_MULTI_CORE
-	#define VOICES		(VOICES_PER_CORE * CORES)
+	#define VOICE_BANKS	CORES
 #else
-	#define VOICES		VOICES_PER_CORE
+	#define VOICE_BANKS	1
 #endif
 
-#ifdef ARM_ALLOW_MULTI_CORE
+#define RENDER_CORE	1				// renders ahead (see StartRenderAhead())
+#define EFFECTS_CORE	(CORES-1)			// runs the reverb (see SetEffectsCore())
+#define EFFECTS_PARTS	2				// dry parts queued for EFFECTS_CORE
+
+#define VOICES		(VOICES_PER_CORE * VOICE_BANKS)
+#define GROUPS		(VOICE_GROUPS * VOICE_BANKS)	// of VECTOR_LANES voices each
 
-enum TCoreStatus
+// How a voice is chosen for a new note, when all voices are in use
+enum TVoiceStealing
 {
-	CoreStatusInit,
-	CoreStatusIdle,
-	CoreStatusBusy,
-	CoreStatusExit,
-	CoreStatusUnknown
+	VoiceStealingNone,				// the note is dropped
+	VoiceStealingOldest,				// the voice with the oldest note on
+	VoiceStealingQuietest,				// the voice with the lowest VCA envelope level
+	VoiceStealingReleasedFirst,			// the longest released voice, else the oldest
+	VoiceStealingUnknown
 };
 
-#endif
+// Renders the next chunk ahead, returns FALSE if there was nothing to do
+typedef boolean TRenderAheadHandler (void *pParam);
 
-// Except Run() and ProcessVoices() everything herein runs on core 0.
-// m_CoreStatus[] is used to synchronize the secondary cores from core 0. Normally
-// m_CoreStatus[] is CoreStatusIdle for all secondary cores and they are spinning
-// to wait until this status changes to CoreStatusBusy. This is triggered in
-// NextSample(), where the major workload is done. Each core processes the same
-// number of voices by calling ProcessVoices() and sums up their current output level
-// to m_fOutputLevel[]. These levels are mixed together when GetOutputLevel() gets
-// called from CMiniSynthesizer::GetChunk(). When the secondary cores have done
-// their work they go back to CoreStatusIdle to be triggered again.
+// Except Run() and ProcessGroups() everything herein runs on core 0 (on RENDER_CORE
+// instead, while rendering ahead, see below).
+// m_CoreSync is used to synchronize the secondary cores from core 0. Normally the
+// secondary cores are idle and sleep, until they are kicked. This is done once per
+// chunk in RenderChunk(), where the major workload is done for a chunk of up to
+// MAX_FRAMES_PER_CHUNK frames. The voices are rendered in groups of VECTOR_LANES
+// voices (see CVoiceBank). Core 0 lists the groups with active voices, and kicks as
+// many secondary cores as there are further groups. Then each core calls
+// ProcessGroups(), which claims the next group from the list with an atomic
+// increment, until the list is exhausted, so that the load follows the active voices
+// and not their numbers. A group is rendered in blocks of FRAMES_PER_BLOCK frames
+// into its own buffer in m_GroupBuffer[]. These buffers are mixed together in the
+// order of the groups (so that the output does not depend on the timing) and fed
+// into the reverb module on core 0 afterwards, which writes the output with the
+// volume of the patch applied into a CRenderRing. When the secondary cores have done
+// their work they go back to idle to be kicked again. When no voice is active and the
+// reverb is idle (see CReverbModule::IsIdle()), RenderChunk() writes silence at once,
+// without waking the other cores, until the next note on.
+//
+// The voices are allocated in constant time (except VoiceStealingQuietest). A voice
+// is on one of three lists: free (idle, last used first), held (ordered by note on)
+// or released (ordered by note off). A new note gets a free voice in the group with
+// the most active voices, which is not full, so that as few groups as possible have
+// to be rendered, otherwise the first free voice. m_ucKeyVoice[] maps a key to the
+// voice, which plays it. The bits in m_nActiveVoices mark the voices, which are not
+// free, so that the cores skip the idle voices quickly. A released voice is stopped,
+// when its VCA envelope falls below the cull level. Voices, which have become idle
+// while rendering, are put back to the free list at the end of RenderChunk(). A
+// stolen voice fades out before its new note.
+//
+// With StartRenderAhead() core 0 kicks RENDER_CORE once, which calls the handler in
+// a loop then, until StopRenderAhead() is called. The handler processes the events
+// and calls RenderChunk() on RENDER_CORE, which kicks the cores after it only, so
+// that core 0 is free for the IRQ handlers, the sound device and the GUI.
+//
+// With SetEffectsCore() the reverb runs on EFFECTS_CORE, which is not used for the
+// voices then. RenderChunk() mixes the groups into the next free entry of a queue of
+// EFFECTS_PARTS dry parts, which also hold the reverb parameters and the volume,
+// and returns. EFFECTS_CORE takes the parts from the queue in order and writes the
+// output into the ring, so that the reverb of a part runs, while the voices of the
+// next one are rendered. The output is the same as without EFFECTS_CORE, but it is
+// written later (see GetPendingFrames()).
+//
+// The voices are held in VOICE_BANKS CVoiceBank objects of VOICES_PER_CORE voices.
+// The banks are allocated in one piece, each starting on its own cache line. Voice n
+// is voice n % VOICES_PER_CORE in bank n / VOICES_PER_CORE. Group n is group
+// n % VOICE_GROUPS in bank n / VOICE_GROUPS.
 
 class CVoiceManager
 #ifdef ARM_ALLOW_MULTI_CORE
@@ -72,32 +119,150 @@ public:
 
 #ifdef ARM_ALLOW_MULTI_CORE
 	void Run (unsigned nCore);			// secondary core entry
+
+	// calls pHandler in a loop on RENDER_CORE, which calls RenderChunk() then
+	void StartRenderAhead (TRenderAheadHandler *pHandler, void *pParam);
+	void StopRenderAhead (void);
+
+	// runs the reverb on EFFECTS_CORE (or not), call it where RenderChunk() is called
+	void SetEffectsCore (boolean bOn);
+
+	// kicks the secondary cores without a job and waits for them, before they are
+	// used otherwise (to measure the wake-up latency)
+	void PingCores (void);
 #endif
 
-	void SetPatch (CPatch *pPatch);
+	// only swaps a pointer, each voice picks the patch up, when it is used next
+	void SetPatch (const TCompiledPatch *pPatch);
+
+	// bRetrigger: a key, which is still playing, re-uses its voice
+	void SetVoiceStealing (TVoiceStealing Policy, boolean bRetrigger = TRUE);
+	// returns the default policy for pName == 0, VoiceStealingUnknown for an invalid name
+	static TVoiceStealing GetVoiceStealing (const char *pName);
+
+	// released voices below -nLevelDB dBFS are stopped (0 to disable)
+	void SetCullLevel (unsigned nLevelDB);
 
 	void NoteOn (u8 ucKeyNumber, u8 ucVelocity);	// MIDI key number and velocity
 	void NoteOff (u8 ucKeyNumber);
 
-	void NextSample (void);
-	float GetOutputLevelLeft (void) const;
-	float GetOutputLevelRight (void) const;
+	// renders the next nFrames stereo output levels (nFrames <= MAX_FRAMES_PER_CHUNK)
+	// into pOutput, which must have room for them and GetPendingFrames()
+	void RenderChunk (unsigned nFrames, CRenderRing *pOutput);
+
+	// returns the number of frames, which have been rendered, but are not written
+	// into the ring yet by EFFECTS_CORE
+	unsigned GetPendingFrames (void) const;
 
 private:
-	float ProcessVoices (unsigned nFirst, unsigned nLast);
+#ifdef ARM_ALLOW_MULTI_CORE
+	void RenderAhead (void);			// runs on RENDER_CORE
+	void ProcessEffects (void);			// runs on EFFECTS_CORE
+#endif
+
+	void RenderEffects (const float *pDry, unsigned nFrames, const TReverbParameters *pReverb,
+			    float fVolume, CRenderRing *pOutput);
+
+	void ProcessGroups (void);			// runs on all cores
+	void ProcessGroup (unsigned nGroup);
+
+	static u32 GetGroupVoices (unsigned nGroup);	// returns the mask of its voices
+
+	enum TVoiceList
+	{
+		VoiceListFree,
+		VoiceListHeld,
+		VoiceListReleased,
+		VoiceListUnknown
+	};
+
+	unsigned GetFreeVoice (void) const;		// returns VOICE_NONE if none
+	unsigned StealVoice (void) const;		// returns VOICE_NONE if none
+	void ReclaimVoices (void);			// puts idle voices back to the free list
+	void UpdateCullLevel (void);
+
+	void Append (TVoiceList List, unsigned nVoice);
+	void Prepend (TVoiceList List, unsigned nVoice);
+	void Remove (unsigned nVoice);
+
+	CVoiceBank *GetBank (unsigned nVoice) const	{ return m_pVoiceBank[nVoice / VOICES_PER_CORE]; }
+	static unsigned GetLane (unsigned nVoice)	{ return nVoice % VOICES_PER_CORE; }
 
 private:
-	CVoice *m_pVoice[VOICES];
+	u8 *m_pVoiceBankBuffer;
+	CVoiceBank *m_pVoiceBank[VOICE_BANKS];
+
+	const TCompiledPatch *m_pPatch;
+
+	TVoiceStealing m_VoiceStealing;
+	boolean m_bRetrigger;
+
+#define VOICE_NONE	VOICES
+	u8 m_ucKeyVoice[128];				// VOICE_NONE if the key is not playing
+	u8 m_ucVoiceKey[VOICES];			// KEY_NUMBER_NONE if the voice is free
+
+	TVoiceList m_VoiceList[VOICES];
+	u8 m_ucPrev[VOICES];				// double linked lists
+	u8 m_ucNext[VOICES];
+	u8 m_ucHead[VoiceListUnknown];
+	u8 m_ucTail[VoiceListUnknown];
+
+	u32 m_nNoteOnSerial[VOICES];			// for VoiceStealingOldest
+	u32 m_nNextSerial;
+
+	u32 m_nActiveVoices;				// bit mask, written on core 0 only
+
+	float m_fCullThreshold;				// of the output level
+	float m_fCullLevel;				// of the VCA envelope
 
-	unsigned m_nLastNoteOnVoice;
+	TReverbParameters m_ReverbParameters;		// of the patch
+	float m_fVolume;
 
 #ifdef ARM_ALLOW_MULTI_CORE
-	volatile TCoreStatus m_CoreStatus[CORES];
+	CCoreSync m_CoreSync;
 
-	volatile float m_fOutputLevel[CORES];
+	TRenderAheadHandler *m_pRenderAheadHandler;	// 0 if not rendering ahead
+	void *m_pRenderAheadParam;
+	volatile boolean m_bRenderAheadStop;
+
+	boolean m_bEffectsCore;
+	volatile boolean m_bEffectsStop;
+
+	struct TEffectsPart
+	{
+		unsigned nFrames;
+		TReverbParameters Reverb;
+		float fVolume;
+		CRenderRing *pOutput;
+		float Dry[MAX_FRAMES_PER_CHUNK];
+	};
+
+	TEffectsPart m_EffectsPart[EFFECTS_PARTS];
+	u32 m_nEffectsWrite;				// written by the renderer only
+	u32 m_nEffectsRead;				// written by EFFECTS_CORE only
+	unsigned m_nPendingFrames;
 #endif
 
+	unsigned m_nFrames;				// of the current chunk
+
+	u8 m_ucGroupList[GROUPS];			// groups with active voices
+	unsigned m_nGroupCount;
+
+	struct TGroupCounter				// index in m_ucGroupList[]
+	{
+		volatile unsigned nNext;
+		u8 Padding[CACHE_LINE_SIZE - sizeof (unsigned)];
+	};
+
+	TGroupCounter m_GroupCounter;
+
+	float m_GroupBuffer[GROUPS][MAX_FRAMES_PER_CHUNK];
+	float m_Buffer[MAX_FRAMES_PER_CHUNK];		// sum of the groups
+
 	CReverbModule m_ReverbModule;
+
+	float m_OutputLeft[MAX_FRAMES_PER_CHUNK];
+	float m_OutputRight[MAX_FRAMES_PER_CHUNK];
 };
 
 #endif
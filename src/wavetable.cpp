@@ -0,0 +1,147 @@
+//
+// wavetable.cpp
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "wavetable.h"
+#include "math.h"
+#include <assert.h>
+
+#define HARMONICS_MAX	512				// for level 0
+
+#define PI_D		3.14159265358979323846
+
+// temporary, while building
+static double SineTable[WAVETABLE_SIZE];
+static double Sum[WAVETABLE_SIZE];
+
+CWaveTable::CWaveTable (void)
+{
+	for (unsigned i = 0; i < WAVETABLE_SIZE; i++)
+	{
+		SineTable[i] = sin (2.0 * PI_D * i / WAVETABLE_SIZE);
+	}
+
+	Build (m_Table[0], WaveformSine, 1);
+
+	for (unsigned nWaveform = WaveformSine+1; nWaveform < WaveformWhiteNoise; nWaveform++)
+	{
+		for (unsigned nLevel = 0; nLevel < WAVETABLE_LEVELS; nLevel++)
+		{
+			Build (m_Table[1 + (nWaveform-1) * WAVETABLE_LEVELS + nLevel],
+			       (TWaveform) nWaveform, HARMONICS_MAX >> nLevel);
+		}
+	}
+}
+
+CWaveTable::~CWaveTable (void)
+{
+}
+
+const float *CWaveTable::GetTable (TWaveform Waveform, unsigned nLevel) const
+{
+	assert (Waveform < WaveformWhiteNoise);
+	assert (nLevel < WAVETABLE_LEVELS);
+
+	if (Waveform == WaveformSine)
+	{
+		return m_Table[0];
+	}
+
+	return m_Table[1 + (Waveform-1) * WAVETABLE_LEVELS + nLevel];
+}
+
+void CWaveTable::Build (float *pTable, TWaveform Waveform, unsigned nHarmonics)
+{
+	assert (pTable != 0);
+	assert (1 <= nHarmonics && nHarmonics < WAVETABLE_SIZE/2);
+
+	// Fourier series of the naive waveforms (phase 0 at start of period):
+	// x(p) = a0 + sum (a[k] * cos (2 pi k p) + b[k] * sin (2 pi k p))
+	double fPulseWidth = 0.5;
+	double a0 = 0.0;
+	switch (Waveform)
+	{
+	case WaveformPulse12:	fPulseWidth = 0.125;	a0 = -0.75;	break;
+	case WaveformPulse25:	fPulseWidth = 0.25;	a0 = -0.5;	break;
+	default:						break;
+	}
+
+	for (unsigned i = 0; i < WAVETABLE_SIZE; i++)
+	{
+		Sum[i] = a0;
+	}
+
+	for (unsigned k = 1; k <= nHarmonics; k++)
+	{
+		double a = 0.0;
+		double b = 0.0;
+
+		switch (Waveform)
+		{
+		case WaveformSine:
+			b = 1.0;
+			break;
+
+		case WaveformSawtooth:
+			b = -2.0 / (PI_D * k);
+			break;
+
+		case WaveformTriangle:
+			if (k & 1)
+			{
+				a = -8.0 / (PI_D * PI_D * k * k);
+			}
+			break;
+
+		case WaveformSquare:
+		case WaveformPulse12:
+		case WaveformPulse25:
+			a = 2.0 / (PI_D * k) * sin (2.0 * PI_D * k * fPulseWidth);
+			b = 2.0 / (PI_D * k) * (1.0 - cos (2.0 * PI_D * k * fPulseWidth));
+			break;
+
+		default:
+			assert (0);
+			break;
+		}
+
+		if (nHarmonics > 1)
+		{
+			double x = PI_D * k / (nHarmonics + 1);
+			double fSigma = sin (x) / x;
+
+			a *= fSigma;
+			b *= fSigma;
+		}
+
+		// the index k*i is taken modulo the table size (a power of 2)
+		for (unsigned i = 0; i < WAVETABLE_SIZE; i++)
+		{
+			unsigned nIndex = k * i;
+			Sum[i] +=   a * SineTable[(nIndex + WAVETABLE_SIZE/4) & (WAVETABLE_SIZE-1)]
+				  + b * SineTable[nIndex & (WAVETABLE_SIZE-1)];
+		}
+	}
+
+	for (unsigned i = 0; i < WAVETABLE_SIZE; i++)
+	{
+		pTable[i] = (float) Sum[i];
+	}
+
+	pTable[WAVETABLE_SIZE] = pTable[0];		// guard sample
+}
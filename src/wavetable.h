@@ -0,0 +1,83 @@
+//
+// wavetable.h
+//
+// Band-limited wave tables for the oscillator waveforms, one per octave
+//
+// MiniSynth Pi - A virtual analogue synthesizer for Raspberry Pi
+// Copyright (C) 2026  R. Stange <rsta2@o2online.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef _wavetable_h
+#define _wavetable_h
+
+#include <circle/types.h>
+#include "oscillator.h"
+
+#define WAVETABLE_SIZE_BITS	11
+#define WAVETABLE_SIZE		(1 << WAVETABLE_SIZE_BITS)	// samples per period
+#define WAVETABLE_LEVELS	10				// octaves with own table
+
+// Each table holds one period plus a guard sample for the interpolation. The
+// table for level n contains 512 >> n harmonics, so that it does not alias
+// with a phase increment below 2^(22+n) (in units of 1/2^32 period). Level 0
+// is used up to 46.9 Hz at 48 kHz, level 9 (sine only) above 12 kHz. The
+// harmonics are weighted with the Lanczos sigma factor to reduce the Gibbs
+// overshoot. The sine wave has one table only.
+
+class CWaveTable
+{
+public:
+	CWaveTable (void);				// builds the tables
+	~CWaveTable (void);
+
+	// returns the level of the table to be used for this phase increment
+	static unsigned GetLevel (u32 nPhaseIncrement);
+
+	const float *GetTable (TWaveform Waveform, unsigned nLevel) const;
+
+	// linear interpolation between the two samples around nPhase
+	static float GetSample (const float *pTable, u32 nPhase);
+
+private:
+	void Build (float *pTable, TWaveform Waveform, unsigned nHarmonics);
+
+private:
+	// sine table and all levels of the other waveforms (except noise)
+	float m_Table[1 + (WaveformWhiteNoise-1) * WAVETABLE_LEVELS][WAVETABLE_SIZE+1];
+};
+
+inline unsigned CWaveTable::GetLevel (u32 nPhaseIncrement)
+{
+	nPhaseIncrement >>= 22;
+	if (nPhaseIncrement == 0)
+	{
+		return 0;
+	}
+
+	unsigned nLevel = 32 - __builtin_clz (nPhaseIncrement);
+
+	return nLevel < WAVETABLE_LEVELS ? nLevel : WAVETABLE_LEVELS-1;
+}
+
+inline float CWaveTable::GetSample (const float *pTable, u32 nPhase)
+{
+	unsigned nIndex = nPhase >> (32-WAVETABLE_SIZE_BITS);
+	float fFraction = (nPhase & ((1U << (32-WAVETABLE_SIZE_BITS))-1))
+			  * (1.0f / (1U << (32-WAVETABLE_SIZE_BITS)));
+
+	return pTable[nIndex] + fFraction * (pTable[nIndex+1] - pTable[nIndex]);
+}
+
+#endif